@@ -15,6 +15,8 @@
 #include "qrtr-bus.h"
 #include "qrtr-node.h"
 #include "qrtr-client.h"
+#include "qrtr-server.h"
+#include "qrtr-traffic.h"
 #include "qrtr-utils.h"
 
 #endif /* _LIBQRTR_GLIB_H_ */
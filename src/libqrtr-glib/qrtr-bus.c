@@ -10,6 +10,7 @@
 #include <endian.h>
 #include <errno.h>
 #include <linux/qrtr.h>
+#include <linux/sock_diag.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/types.h>
@@ -17,7 +18,11 @@
 #include <gio/gio.h>
 
 #include "qrtr-bus.h"
+#include "qrtr-client.h"
+#include "qrtr-deadline.h"
 #include "qrtr-node.h"
+#include "qrtr-reactor.h"
+#include "qrtr-service-table.h"
 #include "qrtr-utils.h"
 
 static void async_initable_iface_init (GAsyncInitableIface *iface);
@@ -29,6 +34,7 @@ enum {
     PROP_0,
     PROP_LOOKUP_TIMEOUT,
     PROP_PORT,
+    PROP_RECEIVE_BUFFER_SIZE,
     PROP_LAST
 };
 
@@ -45,12 +51,50 @@ struct _QrtrBusPrivate {
     /* Underlying QRTR socket */
     GSocket *socket;
 
-    /* List with full references to the available QrtrNodes; i.e. the nodes are
-     * owned by the bus unconditionally. */
-    GList *nodes;
-
-    /* Callback source for when NEW_SERVER/DEL_SERVER control packets come in */
-    GSource *source;
+    /* Maps node ids to NodeRecords, owned by the bus unconditionally */
+    GHashTable *node_records;
+
+    /* List with the QrtrNode objects created so far, sorted by node id when
+     * given to the user (new nodes are prepended, and the list is sorted
+     * once before returning it); the nodes are owned by their records. */
+    GList    *nodes;
+    guint     n_nodes;
+    gboolean  nodes_unsorted;
+
+    /* Callback watch for when NEW_SERVER/DEL_SERVER control packets come in */
+    QrtrReactorWatch *watch;
+
+    /* Receive queue overflow detection; the kernel keeps the cumulative
+     * number of drops in the socket memory info */
+    guint    receive_buffer_size;
+    guint32  last_drop_count;
+    guint64  dropped_packets;
+
+    /* Reconciliation support after drops: set of node/port keys announced
+     * since the last lookup request was sent */
+    gboolean    resync_requested;
+    GHashTable *resync_seen;
+
+    /* All the servers in the bus, for queries */
+    QrtrServiceTable *service_table;
+    /* Shared snapshot of the service table, until it changes */
+    GArray           *services_snapshot;
+    /* Service change subscriptions, and the count of changes in the service
+     * table, so that subscriptions made while a change is being notified,
+     * whose snapshot already includes it, are not notified about it */
+    GHookList         service_hooks;
+    guint64           service_table_version;
+
+    /* Event queues of the consumers, by id */
+    GHashTable *event_queues;
+    gulong      event_queue_id;
+
+    /* Pending node waits: maps node ids to GQueues of NodeWaiters */
+    GHashTable *node_waiters;
+
+    /* Pending service resolutions: maps service numbers to GQueues of
+     * ResolveWaiters */
+    GHashTable *resolve_waiters;
 
     /* initial lookup support */
     guint    lookup_timeout;
@@ -60,6 +104,30 @@ struct _QrtrBusPrivate {
 
 /*****************************************************************************/
 
+/* Compact record kept for every node in the bus. The QrtrNode objects, with
+ * their indices and signals, are only created when a user asks for them, as
+ * most of the nodes in the bus are never used. */
+typedef struct {
+    guint32    node_id;
+    /* Maps ports to QrtrNodeServiceInfo entries, until the node object is
+     * created */
+    GHashTable *services;
+    /* Full reference to the node object, once created */
+    QrtrNode   *node;
+    /* Link of the node object in the list of nodes */
+    GList      *link;
+} NodeRecord;
+
+static void
+node_record_free (NodeRecord *record)
+{
+    if (record->services)
+        g_hash_table_unref (record->services);
+    if (record->node)
+        g_object_unref (record->node);
+    g_slice_free (NodeRecord, record);
+}
+
 static gint
 node_cmp (QrtrNode *a,
           QrtrNode *b)
@@ -67,11 +135,165 @@ node_cmp (QrtrNode *a,
     return qrtr_node_get_id (a) - qrtr_node_get_id (b);
 }
 
-static gint
-node_find_cmp (QrtrNode *a,
-               gpointer  user_data)
+static QrtrNode *
+node_record_peek_node (QrtrBus    *self,
+                       NodeRecord *record)
+{
+    GHashTableIter       iter;
+    QrtrNodeServiceInfo *info;
+
+    if (record->node)
+        return record->node;
+
+    record->node = QRTR_NODE (g_object_new (QRTR_TYPE_NODE,
+                                            QRTR_NODE_BUS, self,
+                                            QRTR_NODE_ID,  record->node_id,
+                                            NULL));
+    g_hash_table_iter_init (&iter, record->services);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&info))
+        qrtr_node_add_service_info (record->node,
+                                    qrtr_node_service_info_get_service (info),
+                                    qrtr_node_service_info_get_port (info),
+                                    qrtr_node_service_info_get_version (info),
+                                    qrtr_node_service_info_get_instance (info));
+    g_clear_pointer (&record->services, g_hash_table_unref);
+
+    self->priv->nodes = g_list_prepend (self->priv->nodes, record->node);
+    self->priv->n_nodes++;
+    self->priv->nodes_unsorted = TRUE;
+    record->link = self->priv->nodes;
+    g_debug ("[qrtr] created node object %u", record->node_id);
+    return record->node;
+}
+
+static void
+node_record_add_service_info (NodeRecord *record,
+                              guint32     port,
+                              guint32     service,
+                              guint32     version,
+                              guint32     instance)
+{
+    QrtrNodeServiceInfo *info;
+
+    /* upsert keyed by port, same as in the node objects */
+    info = g_hash_table_lookup (record->services, GUINT_TO_POINTER (port));
+    if (info && qrtr_node_service_info_match (info, service, version, version, instance))
+        return;
+
+    g_hash_table_insert (record->services, GUINT_TO_POINTER (port),
+                         qrtr_node_service_info_new (service, port, version, instance));
+}
+
+static void
+node_record_remove_service_info (NodeRecord *record,
+                                 guint32     port,
+                                 guint32     service)
 {
-    return qrtr_node_get_id (a) - GPOINTER_TO_UINT (user_data);
+    if (g_hash_table_remove (record->services, GUINT_TO_POINTER (port)))
+        return;
+
+    g_info ("[qrtr node@%u]: tried to remove unknown service %u, port %u",
+            record->node_id, service, port);
+}
+
+static QrtrNodeServiceInfo *
+node_record_peek_service_info (NodeRecord *record,
+                               guint32     service,
+                               guint32     min_version,
+                               guint32     max_version,
+                               guint32     instance)
+{
+    QrtrNodeServiceInfo *found = NULL;
+    QrtrNodeServiceInfo *info;
+    GHashTableIter       iter;
+
+    if (record->node)
+        return qrtr_node_peek_service_info (record->node, service, min_version, max_version, instance);
+
+    g_hash_table_iter_init (&iter, record->services);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&info)) {
+        if (qrtr_node_service_info_match (info, service, min_version, max_version, instance) &&
+            (!found || qrtr_node_service_info_get_version (info) > qrtr_node_service_info_get_version (found)))
+            found = info;
+    }
+
+    return found;
+}
+
+static void node_waiters_check    (QrtrBus *self,
+                                   guint32  node_id);
+static void resolve_waiters_check (QrtrBus *self,
+                                   guint32  node_id,
+                                   guint32  port,
+                                   guint32  service,
+                                   guint32  version,
+                                   guint32  instance);
+
+static void events_push (QrtrBus                    *self,
+                         QrtrBusEventType            type,
+                         const QrtrBusServiceRecord *record);
+
+static void
+notify_node_change (QrtrBus *self,
+                    guint32  node_id,
+                    gboolean added)
+{
+    QrtrBusServiceRecord record;
+
+    if (self->priv->event_queues && g_hash_table_size (self->priv->event_queues)) {
+        memset (&record, 0, sizeof (record));
+        record.node_id = node_id;
+        events_push (self,
+                     added ? QRTR_BUS_EVENT_TYPE_NODE_ADDED : QRTR_BUS_EVENT_TYPE_NODE_REMOVED,
+                     &record);
+    }
+
+    g_signal_emit (self, signals[added ? SIGNAL_NODE_ADDED : SIGNAL_NODE_REMOVED], 0, node_id);
+}
+
+typedef struct {
+    GHook   hook;
+    /* version of the service table in the snapshot given */
+    guint64 version;
+} ServiceHook;
+
+typedef struct {
+    QrtrBus                    *self;
+    gboolean                    added;
+    const QrtrBusServiceRecord *record;
+} ServiceChange;
+
+static void
+service_hook_marshal (GHook         *hook,
+                      ServiceChange *change)
+{
+    if (((ServiceHook *) hook)->version >= change->self->priv->service_table_version)
+        return;
+    ((QrtrBusServiceFunc) hook->func) (change->self, change->added, change->record, hook->data);
+}
+
+static void
+notify_service_change (QrtrBus                    *self,
+                       gboolean                    added,
+                       const QrtrBusServiceRecord *record)
+{
+    ServiceChange change;
+
+    g_clear_pointer (&self->priv->services_snapshot, g_array_unref);
+
+    if (self->priv->event_queues && g_hash_table_size (self->priv->event_queues))
+        events_push (self,
+                     added ? QRTR_BUS_EVENT_TYPE_SERVICE_ADDED : QRTR_BUS_EVENT_TYPE_SERVICE_REMOVED,
+                     record);
+
+    /* subscriptions are cleared on dispose */
+    if (!self->priv->service_hooks.is_setup)
+        return;
+
+    change.self = self;
+    change.added = added;
+    change.record = record;
+    g_hook_list_marshal (&self->priv->service_hooks, FALSE, (GHookMarshaller) service_hook_marshal, &change);
 }
 
 static void
@@ -82,297 +304,1280 @@ add_service_info (QrtrBus *self,
                   guint32  version,
                   guint32  instance)
 {
-    GList    *list_item;
+    NodeRecord           *record;
+    QrtrBusServiceRecord  previous;
+    QrtrBusServiceRecord  added;
+
+    record = g_hash_table_lookup (self->priv->node_records, GUINT_TO_POINTER (node_id));
+    if (!record) {
+        /* Node records are exclusively created at this point */
+        record = g_slice_new0 (NodeRecord);
+        record->node_id = node_id;
+        record->services = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                  (GDestroyNotify)qrtr_node_service_info_free);
+        g_hash_table_insert (self->priv->node_records, GUINT_TO_POINTER (node_id), record);
+        g_debug ("[qrtr] created new node %u", node_id);
+        notify_node_change (self, node_id, TRUE);
+        node_waiters_check (self, node_id);
+    }
+
+    if (record->node)
+        qrtr_node_add_service_info (record->node, service, port, version, instance);
+    else
+        node_record_add_service_info (record, port, service, version, instance);
+
+    added.node_id = node_id;
+    added.service = service;
+    added.port = port;
+    added.version = version;
+    added.instance = instance;
+    self->priv->service_table_version++;
+    if (!qrtr_service_table_upsert (self->priv->service_table, node_id, port, service, version, instance, &previous))
+        notify_service_change (self, TRUE, &added);
+    else if (memcmp (&previous, &added, sizeof (added)) != 0) {
+        /* a different server in the same port; re-announcements of known
+         * servers are not changes */
+        notify_service_change (self, FALSE, &previous);
+        notify_service_change (self, TRUE, &added);
+    }
+
+    resolve_waiters_check (self, node_id, port, service, version, instance);
+}
+
+static void
+remove_service_info (QrtrBus *self,
+                     guint32  node_id,
+                     guint32  port,
+                     guint32  service,
+                     guint32  version,
+                     guint32  instance)
+{
+    NodeRecord           *record;
+    QrtrBusServiceRecord  removed;
+
+    record = g_hash_table_lookup (self->priv->node_records, GUINT_TO_POINTER (node_id));
+    if (!record) {
+        g_warning ("[qrtr] cannot remove service info: nonexistent node %u", node_id);
+        return;
+    }
+
+    self->priv->service_table_version++;
+    if (qrtr_service_table_remove (self->priv->service_table, node_id, port, &removed))
+        notify_service_change (self, FALSE, &removed);
+
+    if (record->node) {
+        qrtr_node_remove_service_info (record->node, service, port, version, instance);
+        if (qrtr_node_peek_service_info_list (record->node))
+            return;
+    } else {
+        node_record_remove_service_info (record, port, service);
+        if (g_hash_table_size (record->services))
+            return;
+    }
+
+    g_debug ("[qrtr] removing node %u", node_id);
+    if (record->node) {
+        /* notify the node directly, the signal is for external listeners */
+        qrtr_node_set_removed (record->node);
+        self->priv->nodes = g_list_delete_link (self->priv->nodes, record->link);
+        self->priv->n_nodes--;
+    }
+    notify_node_change (self, node_id, FALSE);
+    g_hash_table_remove (self->priv->node_records, GUINT_TO_POINTER (node_id));
+}
+
+/*****************************************************************************/
+
+static void     initable_complete       (QrtrBus  *self);
+static gboolean send_lookup_ctrl_packet (QrtrBus  *self,
+                                         guint32   cmd,
+                                         GError  **error);
+
+static guint64 *
+resync_key_new (guint32 node_id,
+                guint32 port)
+{
+    guint64 *key;
+
+    key = g_new (guint64, 1);
+    *key = qrtr_address_key (node_id, port);
+    return key;
+}
+
+static void
+resync_start (QrtrBus *self)
+{
+    g_autoptr(GError) error = NULL;
+
+    self->priv->resync_requested = FALSE;
+
+    /* Remove our previous lookup before adding a new one, or the name service
+     * would notify every change twice from now on. The new lookup makes the
+     * name service replay all known servers and finish with an empty one. */
+    if (!send_lookup_ctrl_packet (self, QRTR_TYPE_DEL_LOOKUP, &error) ||
+        !send_lookup_ctrl_packet (self, QRTR_TYPE_NEW_LOOKUP, &error)) {
+        g_warning ("[qrtr] couldn't request new lookup: %s", error->message);
+        return;
+    }
+
+    g_debug ("[qrtr] new lookup requested to reconcile bus state");
+    if (self->priv->resync_seen)
+        g_hash_table_remove_all (self->priv->resync_seen);
+    else
+        self->priv->resync_seen = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
+}
+
+typedef struct {
+    guint32 node_id;
+    guint32 port;
+    guint32 service;
+    guint32 version;
+    guint32 instance;
+} StaleServer;
+
+static void
+resync_check_stale (GHashTable          *seen,
+                    guint32              node_id,
+                    QrtrNodeServiceInfo *info,
+                    GArray              *stale)
+{
+    StaleServer server;
+    guint64     key;
+
+    server.node_id = node_id;
+    server.port = qrtr_node_service_info_get_port (info);
+    key = qrtr_address_key (server.node_id, server.port);
+    if (g_hash_table_contains (seen, &key))
+        return;
+
+    server.service = qrtr_node_service_info_get_service (info);
+    server.version = qrtr_node_service_info_get_version (info);
+    server.instance = qrtr_node_service_info_get_instance (info);
+    g_array_append_val (stale, server);
+}
+
+static void
+resync_finish (QrtrBus *self)
+{
+    g_autoptr(GHashTable)  seen = NULL;
+    g_autoptr(GArray)      stale = NULL;
+    GHashTableIter         iter;
+    NodeRecord            *record;
+    guint                  i;
+
+    seen = g_steal_pointer (&self->priv->resync_seen);
+    if (!seen)
+        return;
+
+    /* Any server we know about which wasn't announced again must have been
+     * removed while we were losing packets. If the replay that just finished
+     * was not the one of the last lookup requested, this may remove servers
+     * that are announced again right away, but we always converge to the
+     * name service view. */
+    stale = g_array_new (FALSE, FALSE, sizeof (StaleServer));
+    g_hash_table_iter_init (&iter, self->priv->node_records);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&record)) {
+        if (record->node) {
+            GList *l;
+
+            for (l = qrtr_node_peek_service_info_list (record->node); l; l = g_list_next (l))
+                resync_check_stale (seen, record->node_id, l->data, stale);
+        } else {
+            GHashTableIter       services_iter;
+            QrtrNodeServiceInfo *info;
+
+            g_hash_table_iter_init (&services_iter, record->services);
+            while (g_hash_table_iter_next (&services_iter, NULL, (gpointer *)&info))
+                resync_check_stale (seen, record->node_id, info, stale);
+        }
+    }
+
+    for (i = 0; i < stale->len; i++) {
+        StaleServer *server = &g_array_index (stale, StaleServer, i);
+
+        g_debug ("[qrtr] stale server on %u:%u -> service %u, version %u, instance %u",
+                 server->node_id, server->port, server->service, server->version, server->instance);
+        remove_service_info (self, server->node_id, server->port, server->service, server->version, server->instance);
+    }
+}
+
+static void
+process_drop_count (QrtrBus *self,
+                    guint32  drop_count)
+{
+    guint32 new_drops;
+
+    /* cumulative counter, wrap-around safe */
+    new_drops = drop_count - self->priv->last_drop_count;
+    if (!new_drops)
+        return;
+
+    self->priv->last_drop_count = drop_count;
+    self->priv->dropped_packets += new_drops;
+    g_warning ("[qrtr] %u control packets dropped: bus state needs to be reconciled", new_drops);
+
+    /* the new lookup is requested once all already queued packets are processed */
+    self->priv->resync_requested = TRUE;
+}
+
+static void
+check_lost_packets (QrtrBus *self)
+{
+    guint32   meminfo[SK_MEMINFO_VARS];
+    socklen_t len;
+
+    /* AF_QIPCRTR doesn't report drops as ancillary data, but the socket
+     * memory info has both the drop counter and the bytes still queued */
+    len = sizeof (meminfo);
+    if (getsockopt (g_socket_get_fd (self->priv->socket), SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0 ||
+        len < sizeof (meminfo)) {
+        g_debug ("[qrtr] couldn't get socket memory info: %s", g_strerror (errno));
+        return;
+    }
+
+    process_drop_count (self, meminfo[SK_MEMINFO_DROPS]);
+
+    if (self->priv->resync_requested && !meminfo[SK_MEMINFO_RMEM_ALLOC])
+        resync_start (self);
+}
+
+static void
+process_ctrl_packet (QrtrBus                    *self,
+                     const struct qrtr_ctrl_pkt *ctrl_packet,
+                     gssize                      bytes_received)
+{
+    guint32 type;
+    guint32 node_id;
+    guint32 port;
+    guint32 service;
+    guint32 version;
+    guint32 instance;
+
+    if ((gsize)bytes_received < sizeof (*ctrl_packet)) {
+        g_debug ("[qrtr] short packet received: ignoring");
+        return;
+    }
+
+    type = GUINT32_FROM_LE (ctrl_packet->cmd);
+    if (type != QRTR_TYPE_NEW_SERVER && type != QRTR_TYPE_DEL_SERVER) {
+        g_debug ("[qrtr] unknown packet type received: 0x%x", type);
+        return;
+    }
+
+    /* type is something we handle, parse the packet */
+    node_id = GUINT32_FROM_LE (ctrl_packet->server.node);
+    port = GUINT32_FROM_LE (ctrl_packet->server.port);
+    service = GUINT32_FROM_LE (ctrl_packet->server.service);
+    version = GUINT32_FROM_LE (ctrl_packet->server.instance) & 0xff;
+    instance = GUINT32_FROM_LE (ctrl_packet->server.instance) >> 8;
+
+    if (type == QRTR_TYPE_DEL_SERVER) {
+        g_debug ("[qrtr] removed server on %u:%u -> service %u, version %u, instance %u",
+                 node_id, port, service, version, instance);
+        if (self->priv->resync_seen) {
+            guint64 key;
+
+            key = qrtr_address_key (node_id, port);
+            g_hash_table_remove (self->priv->resync_seen, &key);
+        }
+        remove_service_info (self, node_id, port, service, version, instance);
+        return;
+    }
+
+    g_assert (type == QRTR_TYPE_NEW_SERVER);
+
+    if (!node_id && !port && !service && !version && !instance) {
+        g_debug ("[qrtr] lookup finished");
+        initable_complete (self);
+        resync_finish (self);
+        return;
+    }
+
+    g_debug ("[qrtr] added server on %u:%u -> service %u, version %u, instance %u",
+             node_id, port, service, version, instance);
+    if (self->priv->resync_seen)
+        g_hash_table_add (self->priv->resync_seen, resync_key_new (node_id, port));
+    add_service_info (self, node_id, port, service, version, instance);
+}
+
+static gboolean
+qrtr_ctrl_message_cb (QrtrBus *self)
+{
+    struct qrtr_ctrl_pkt ctrl_packet;
+    gssize               bytes_received;
+
+    bytes_received = recv (g_socket_get_fd (self->priv->socket), &ctrl_packet, sizeof (ctrl_packet), MSG_DONTWAIT);
+    if (bytes_received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return TRUE;
+        g_warning ("[qrtr] socket i/o failure: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    /* check for message type and add/remove nodes here */
+    process_ctrl_packet (self, &ctrl_packet, bytes_received);
+
+    check_lost_packets (self);
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+QrtrNode *
+qrtr_bus_peek_node (QrtrBus *self,
+                    guint32  node_id)
+{
+    NodeRecord *record;
+
+    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+
+    record = g_hash_table_lookup (self->priv->node_records, GUINT_TO_POINTER (node_id));
+    return (record ? node_record_peek_node (self, record) : NULL);
+}
+
+QrtrNode *
+qrtr_bus_get_node (QrtrBus *self,
+                   guint32  node_id)
+{
     QrtrNode *node;
 
-    list_item = g_list_find_custom (self->priv->nodes, GUINT_TO_POINTER (node_id), (GCompareFunc)node_find_cmp);
-    if (!list_item) {
-        /* Node objects are exclusively created at this point */
-        node = QRTR_NODE (g_object_new (QRTR_TYPE_NODE,
-                                        QRTR_NODE_BUS, self,
-                                        QRTR_NODE_ID,  node_id,
-                                        NULL));
+    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
 
-        self->priv->nodes = g_list_insert_sorted (self->priv->nodes, node, (GCompareFunc)node_cmp);
-        g_debug ("[qrtr] created new node %u", node_id);
-        g_signal_emit (self, signals[SIGNAL_NODE_ADDED], 0, node_id);
-    } else
-        node = QRTR_NODE (list_item->data);
+    node = qrtr_bus_peek_node (self, node_id);
+    return (node ? g_object_ref (node) : NULL);
+}
+
+static void
+peek_all_nodes (QrtrBus *self)
+{
+    GHashTableIter  iter;
+    NodeRecord     *record;
+
+    if (self->priv->n_nodes < g_hash_table_size (self->priv->node_records)) {
+        g_hash_table_iter_init (&iter, self->priv->node_records);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&record))
+            node_record_peek_node (self, record);
+    }
+
+    /* sorting keeps the list elements, so the links in the records are
+     * still valid */
+    if (self->priv->nodes_unsorted) {
+        self->priv->nodes = g_list_sort (self->priv->nodes, (GCompareFunc)node_cmp);
+        self->priv->nodes_unsorted = FALSE;
+    }
+}
+
+GList *
+qrtr_bus_peek_nodes (QrtrBus *self)
+{
+    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+
+    peek_all_nodes (self);
+    return self->priv->nodes;
+}
+
+GList *
+qrtr_bus_get_nodes (QrtrBus *self)
+{
+    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+
+    peek_all_nodes (self);
+    return g_list_copy_deep (self->priv->nodes, (GCopyFunc) g_object_ref, NULL);
+}
+
+/*****************************************************************************/
+
+gboolean
+qrtr_bus_lookup_service (QrtrBus *self,
+                         guint32  service,
+                         guint32  min_version,
+                         guint32  max_version,
+                         guint32  instance,
+                         guint32 *node_id,
+                         guint32 *port)
+{
+    NodeRecord          *found_record = NULL;
+    QrtrNodeServiceInfo *found_info = NULL;
+    GHashTableIter       iter;
+    NodeRecord          *record;
+
+    g_return_val_if_fail (QRTR_IS_BUS (self), FALSE);
+
+    g_hash_table_iter_init (&iter, self->priv->node_records);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&record)) {
+        QrtrNodeServiceInfo *info;
+        guint32              info_version;
+        guint32              found_version;
+
+        info = node_record_peek_service_info (record, service, min_version, max_version, instance);
+        if (!info)
+            continue;
+
+        /* on version ties, keep the one with the lowest node id */
+        if (found_info) {
+            info_version = qrtr_node_service_info_get_version (info);
+            found_version = qrtr_node_service_info_get_version (found_info);
+            if (info_version < found_version ||
+                (info_version == found_version && record->node_id > found_record->node_id))
+                continue;
+        }
+
+        found_record = record;
+        found_info = info;
+    }
+
+    if (!found_info)
+        return FALSE;
+
+    if (node_id)
+        *node_id = found_record->node_id;
+    if (port)
+        *port = qrtr_node_service_info_get_port (found_info);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+guint64
+qrtr_bus_get_dropped_packets (QrtrBus *self)
+{
+    g_return_val_if_fail (QRTR_IS_BUS (self), 0);
+
+    return self->priv->dropped_packets;
+}
+
+/*****************************************************************************/
+
+/* The timeout and cancellable sources of the waiter share the ownership of
+ * the task; whichever completes it first takes it, after removing the
+ * waiter. */
+typedef struct {
+    QrtrBus *self;
+    GTask   *task;
+    guint32  node_id;
+    /* link in the queue of waiters of the node */
+    GList             *link;
+    QrtrDeadlineTimer *timer;
+    GSource *cancellable_source;
+} NodeWaiter;
+
+static GTask *
+node_waiter_take_task (NodeWaiter *waiter)
+{
+    GQueue *queue;
+    GTask  *task;
+
+    queue = g_hash_table_lookup (waiter->self->priv->node_waiters, GUINT_TO_POINTER (waiter->node_id));
+    g_assert (queue);
+    g_queue_delete_link (queue, waiter->link);
+    if (g_queue_is_empty (queue))
+        g_hash_table_remove (waiter->self->priv->node_waiters, GUINT_TO_POINTER (waiter->node_id));
+
+    if (waiter->timer)
+        qrtr_deadline_timer_remove (waiter->timer);
+    if (waiter->cancellable_source) {
+        g_source_destroy (waiter->cancellable_source);
+        g_source_unref (waiter->cancellable_source);
+    }
+
+    task = waiter->task;
+    g_slice_free (NodeWaiter, waiter);
+    return task;
+}
+
+static gboolean
+node_waiter_timeout_cb (NodeWaiter *waiter)
+{
+    GTask   *task;
+    guint32  node_id;
+
+    node_id = waiter->node_id;
+    task = node_waiter_take_task (waiter);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                             "QRTR node %u did not appear on the bus", node_id);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+node_waiter_cancelled_cb (GCancellable *cancellable,
+                          NodeWaiter   *waiter)
+{
+    GTask *task;
+
+    task = node_waiter_take_task (waiter);
+    g_task_return_error_if_cancelled (task);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+node_waiters_check (QrtrBus *self,
+                    guint32  node_id)
+{
+    g_autoptr(GPtrArray)  tasks = NULL;
+    g_autoptr(QrtrNode)   node = NULL;
+    GQueue               *queue;
+    guint                 i;
+
+    queue = g_hash_table_lookup (self->priv->node_waiters, GUINT_TO_POINTER (node_id));
+    if (!queue)
+        return;
+
+    /* Take all the waiters before completing any, as completing a task may
+     * run user code that modifies the waiters. */
+    tasks = g_ptr_array_new ();
+    while (g_hash_table_lookup (self->priv->node_waiters, GUINT_TO_POINTER (node_id)) == queue)
+        g_ptr_array_add (tasks, node_waiter_take_task (g_queue_peek_head (queue)));
+
+    node = qrtr_bus_get_node (self, node_id);
+    for (i = 0; i < tasks->len; i++) {
+        GTask *task = g_ptr_array_index (tasks, i);
+
+        g_task_return_pointer (task, g_object_ref (node), g_object_unref);
+        g_object_unref (task);
+    }
+}
+
+static void
+node_waiters_cancel_all (QrtrBus *self)
+{
+    g_autoptr(GPtrArray) tasks = NULL;
+    GHashTableIter       iter;
+    GQueue              *queue;
+    guint                i;
+
+    tasks = g_ptr_array_new ();
+    while (g_hash_table_size (self->priv->node_waiters) > 0) {
+        g_hash_table_iter_init (&iter, self->priv->node_waiters);
+        g_hash_table_iter_next (&iter, NULL, (gpointer *)&queue);
+        g_ptr_array_add (tasks, node_waiter_take_task (g_queue_peek_head (queue)));
+    }
+
+    for (i = 0; i < tasks->len; i++) {
+        GTask *task = g_ptr_array_index (tasks, i);
+
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                                 "QRTR bus is closed");
+        g_object_unref (task);
+    }
+}
+
+QrtrNode *
+qrtr_bus_wait_for_node_finish (QrtrBus       *self,
+                               GAsyncResult  *res,
+                               GError       **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+void
+qrtr_bus_wait_for_node_until (QrtrBus             *self,
+                              guint32              node_id,
+                              gint64               deadline,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    GTask      *task;
+    NodeWaiter *waiter;
+    GQueue     *queue;
+    QrtrNode   *existing_node;
+
+    g_return_if_fail (QRTR_IS_BUS (self));
+
+    task = g_task_new (self, cancellable, callback, user_data);
+
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
+    }
+
+    /* Nothing to do if it already exists */
+    existing_node = qrtr_bus_get_node (self, node_id);
+    if (existing_node) {
+        g_task_return_pointer (task, existing_node, (GDestroyNotify)g_object_unref);
+        g_object_unref (task);
+        return;
+    }
+
+    waiter = g_slice_new0 (NodeWaiter);
+    waiter->self = self;
+    waiter->task = task;
+    waiter->node_id = node_id;
+
+    queue = g_hash_table_lookup (self->priv->node_waiters, GUINT_TO_POINTER (node_id));
+    if (!queue) {
+        queue = g_queue_new ();
+        g_hash_table_insert (self->priv->node_waiters, GUINT_TO_POINTER (node_id), queue);
+    }
+    g_queue_push_tail (queue, waiter);
+    waiter->link = g_queue_peek_tail_link (queue);
+
+    /* Setup timeout for the operation */
+    waiter->timer = qrtr_deadline_timer_add (g_main_context_get_thread_default (), deadline,
+                                             (GSourceFunc)node_waiter_timeout_cb, waiter);
+
+    /* Release the waiter as soon as the operation is cancelled */
+    if (cancellable) {
+        waiter->cancellable_source = g_cancellable_source_new (cancellable);
+        g_source_set_callback (waiter->cancellable_source, (GSourceFunc)node_waiter_cancelled_cb, waiter, NULL);
+        g_source_attach (waiter->cancellable_source, g_main_context_get_thread_default ());
+    }
+}
+
+void
+qrtr_bus_wait_for_node (QrtrBus             *self,
+                        guint32              node_id,
+                        guint                timeout_ms,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+    g_return_if_fail (timeout_ms > 0);
+
+    qrtr_bus_wait_for_node_until (self, node_id, qrtr_deadline_from_timeout (timeout_ms),
+                                  cancellable, callback, user_data);
+}
+
+/*****************************************************************************/
+
+guint
+qrtr_bus_query_services (QrtrBus                    *self,
+                         const QrtrBusServiceFilter *filter,
+                         GArray                     *results)
+{
+    g_return_val_if_fail (QRTR_IS_BUS (self), 0);
+    g_return_val_if_fail (filter, 0);
+    g_return_val_if_fail (!filter->n_services || filter->services, 0);
+    g_return_val_if_fail (g_array_get_element_size (results) == sizeof (QrtrBusServiceRecord), 0);
+
+    return qrtr_service_table_query (self->priv->service_table, filter, results);
+}
+
+GArray *
+qrtr_bus_subscribe_services (QrtrBus            *self,
+                             QrtrBusServiceFunc  callback,
+                             gpointer            user_data,
+                             GDestroyNotify      destroy,
+                             gulong             *subscription_id)
+{
+    GHook *hook;
+
+    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+    g_return_val_if_fail (callback, NULL);
+    g_return_val_if_fail (subscription_id, NULL);
+
+    if (!self->priv->services_snapshot) {
+        QrtrBusServiceFilter filter;
+
+        memset (&filter, 0, sizeof (filter));
+        filter.node_id = QRTR_BUS_NODE_ID_ANY;
+        filter.max_version = G_MAXUINT32;
+        filter.instance = QRTR_NODE_INSTANCE_ANY;
+        self->priv->services_snapshot = g_array_new (FALSE, FALSE, sizeof (QrtrBusServiceRecord));
+        qrtr_service_table_query (self->priv->service_table, &filter, self->priv->services_snapshot);
+    }
+
+    hook = g_hook_alloc (&self->priv->service_hooks);
+    ((ServiceHook *) hook)->version = self->priv->service_table_version;
+    hook->func = (gpointer) callback;
+    hook->data = user_data;
+    hook->destroy = destroy;
+    g_hook_append (&self->priv->service_hooks, hook);
+    *subscription_id = hook->hook_id;
+
+    return g_array_ref (self->priv->services_snapshot);
+}
+
+void
+qrtr_bus_unsubscribe_services (QrtrBus *self,
+                               gulong   subscription_id)
+{
+    g_return_if_fail (QRTR_IS_BUS (self));
+
+    if (!g_hook_destroy (&self->priv->service_hooks, subscription_id))
+        g_warning ("[qrtr] unknown service subscription %lu", subscription_id);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    GArray *events;
+    guint   n_dropped;
+} EventsResult;
+
+static void
+events_result_free (EventsResult *result)
+{
+    g_array_unref (result->events);
+    g_slice_free (EventsResult, result);
+}
+
+/* Each consumer has its own queue, as a ring of max_events, and may have
+ * its own pending qrtr_bus_next_events() */
+typedef struct {
+    gulong                id;
+    QrtrBusEvent         *events;
+    guint                 max_events;
+    guint                 head;
+    guint                 n_events;
+    guint                 n_dropped;
+    QrtrBusEventOverflow  overflow;
+    GTask                *task;
+    GSource              *source;
+    GSource              *cancellable_source;
+} EventQueue;
+
+static GTask *
+event_queue_take_task (EventQueue *queue)
+{
+    if (queue->source) {
+        g_source_destroy (queue->source);
+        g_clear_pointer (&queue->source, g_source_unref);
+    }
+    if (queue->cancellable_source) {
+        g_source_destroy (queue->cancellable_source);
+        g_clear_pointer (&queue->cancellable_source, g_source_unref);
+    }
+    return g_steal_pointer (&queue->task);
+}
+
+static void
+event_queue_free (EventQueue *queue)
+{
+    if (queue->task) {
+        GTask *task;
+
+        task = event_queue_take_task (queue);
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                                 "QRTR bus event queue removed");
+        g_object_unref (task);
+    }
+    g_free (queue->events);
+    g_slice_free (EventQueue, queue);
+}
+
+static EventsResult *
+event_queue_take_all (EventQueue *queue)
+{
+    EventsResult *result;
+    guint         first;
+
+    result = g_slice_new (EventsResult);
+    result->events = g_array_sized_new (FALSE, FALSE, sizeof (QrtrBusEvent), queue->n_events);
+
+    /* the ring may wrap around */
+    first = MIN (queue->n_events, queue->max_events - queue->head);
+    g_array_append_vals (result->events, &queue->events[queue->head], first);
+    g_array_append_vals (result->events, queue->events, queue->n_events - first);
+    result->n_dropped = queue->n_dropped;
+
+    queue->head = 0;
+    queue->n_events = 0;
+    queue->n_dropped = 0;
+    return result;
+}
+
+static gboolean
+event_queue_ready_cb (EventQueue *queue)
+{
+    GTask *task;
+
+    task = event_queue_take_task (queue);
+    g_task_return_pointer (task, event_queue_take_all (queue), (GDestroyNotify)events_result_free);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+event_queue_cancelled_cb (GCancellable *cancellable,
+                          EventQueue   *queue)
+{
+    GTask *task;
+
+    task = event_queue_take_task (queue);
+    g_task_return_error_if_cancelled (task);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+event_queue_schedule (EventQueue *queue)
+{
+    /* report all the events of this main loop iteration together */
+    if (!queue->task || queue->source)
+        return;
+
+    queue->source = g_idle_source_new ();
+    g_source_set_callback (queue->source, (GSourceFunc)event_queue_ready_cb, queue, NULL);
+    g_source_attach (queue->source, g_task_get_context (queue->task));
+}
+
+static void
+event_queue_push (EventQueue                 *queue,
+                  QrtrBusEventType            type,
+                  const QrtrBusServiceRecord *record)
+{
+    QrtrBusEvent *event;
+
+    if (queue->n_events == queue->max_events) {
+        queue->n_dropped++;
+        if (queue->overflow == QRTR_BUS_EVENT_OVERFLOW_DROP_NEWEST)
+            return;
+        queue->head = (queue->head + 1) % queue->max_events;
+        queue->n_events--;
+    }
+
+    event = &queue->events[(queue->head + queue->n_events) % queue->max_events];
+    event->type = type;
+    event->record = *record;
+    queue->n_events++;
+
+    event_queue_schedule (queue);
+}
+
+static void
+events_push (QrtrBus                    *self,
+             QrtrBusEventType            type,
+             const QrtrBusServiceRecord *record)
+{
+    GHashTableIter  iter;
+    EventQueue     *queue;
+
+    g_hash_table_iter_init (&iter, self->priv->event_queues);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&queue))
+        event_queue_push (queue, type, record);
+}
 
-    qrtr_node_add_service_info (node, service, port, version, instance);
+gulong
+qrtr_bus_add_event_queue (QrtrBus              *self,
+                          guint                 max_events,
+                          QrtrBusEventOverflow  overflow)
+{
+    EventQueue *queue;
+
+    g_return_val_if_fail (QRTR_IS_BUS (self), 0);
+    g_return_val_if_fail (max_events > 0, 0);
+
+    if (!self->priv->event_queues)
+        self->priv->event_queues = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                          NULL, (GDestroyNotify)event_queue_free);
+
+    queue = g_slice_new0 (EventQueue);
+    queue->id = ++self->priv->event_queue_id;
+    queue->events = g_new (QrtrBusEvent, max_events);
+    queue->max_events = max_events;
+    queue->overflow = overflow;
+    g_hash_table_insert (self->priv->event_queues, GSIZE_TO_POINTER (queue->id), queue);
+    return queue->id;
 }
 
-static void
-remove_service_info (QrtrBus *self,
-                     guint32  node_id,
-                     guint32  port,
-                     guint32  service,
-                     guint32  version,
-                     guint32  instance)
+void
+qrtr_bus_remove_event_queue (QrtrBus *self,
+                             gulong   queue_id)
 {
-    GList    *list_item;
-    QrtrNode *node;
+    EventQueue *queue;
 
-    list_item = g_list_find_custom (self->priv->nodes, GUINT_TO_POINTER (node_id), (GCompareFunc)node_find_cmp);
-    if (!list_item) {
-        g_warning ("[qrtr] cannot remove service info: nonexistent node %u", node_id);
+    g_return_if_fail (QRTR_IS_BUS (self));
+
+    queue = self->priv->event_queues ? g_hash_table_lookup (self->priv->event_queues, GSIZE_TO_POINTER (queue_id)) : NULL;
+    if (!queue) {
+        g_warning ("[qrtr] unknown event queue %lu", queue_id);
         return;
     }
 
-    node = QRTR_NODE (list_item->data);
-    qrtr_node_remove_service_info (node, service, port, version, instance);
-
-    if (!qrtr_node_peek_service_info_list (node)) {
-        g_debug ("[qrtr] removing node %u", node_id);
-        g_signal_emit (self, signals[SIGNAL_NODE_REMOVED], 0, node_id);
-        self->priv->nodes = g_list_delete_link (self->priv->nodes, list_item);
-    }
+    /* the pending operation, if any, is completed once the queue is no
+     * longer reachable */
+    g_hash_table_steal (self->priv->event_queues, GSIZE_TO_POINTER (queue_id));
+    event_queue_free (queue);
 }
 
-/*****************************************************************************/
-
-static void initable_complete (QrtrBus *self);
+GArray *
+qrtr_bus_next_events_finish (QrtrBus       *self,
+                             GAsyncResult  *res,
+                             guint         *n_dropped,
+                             GError       **error)
+{
+    EventsResult *result;
+    GArray       *events;
+
+    result = g_task_propagate_pointer (G_TASK (res), error);
+    if (!result)
+        return NULL;
+
+    if (n_dropped)
+        *n_dropped = result->n_dropped;
+    events = g_steal_pointer (&result->events);
+    g_slice_free (EventsResult, result);
+    return events;
+}
 
-static gboolean
-qrtr_ctrl_message_cb (GSocket      *gsocket,
-                      GIOCondition  cond,
-                      QrtrBus      *self)
-{
-    GError               *error = NULL;
-    struct qrtr_ctrl_pkt  ctrl_packet;
-    gssize                bytes_received;
-    guint32               type;
-    guint32               node_id;
-    guint32               port;
-    guint32               service;
-    guint32               version;
-    guint32               instance;
+void
+qrtr_bus_next_events (QrtrBus             *self,
+                      gulong               queue_id,
+                      GCancellable        *cancellable,
+                      GAsyncReadyCallback  callback,
+                      gpointer             user_data)
+{
+    GTask      *task;
+    EventQueue *queue;
 
-    /* check for message type and add/remove nodes here */
+    g_return_if_fail (QRTR_IS_BUS (self));
 
-    bytes_received = g_socket_receive (gsocket, (gchar *)&ctrl_packet,
-                                       sizeof (ctrl_packet), NULL, &error);
-    if (bytes_received < 0) {
-        g_warning ("[qrtr] socket i/o failure: %s", error->message);
-        g_error_free (error);
-        return FALSE;
-    }
+    task = g_task_new (self, cancellable, callback, user_data);
 
-    if ((gsize)bytes_received < sizeof (ctrl_packet)) {
-        g_debug ("[qrtr] short packet received: ignoring");
-        return TRUE;
+    queue = self->priv->event_queues ? g_hash_table_lookup (self->priv->event_queues, GSIZE_TO_POINTER (queue_id)) : NULL;
+    if (!queue) {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                                 "QRTR bus event queue %lu not found", queue_id);
+        g_object_unref (task);
+        return;
     }
 
-    type = GUINT32_FROM_LE (ctrl_packet.cmd);
-    if (type != QRTR_TYPE_NEW_SERVER && type != QRTR_TYPE_DEL_SERVER) {
-        g_debug ("[qrtr] unknown packet type received: 0x%x", type);
-        return TRUE;
+    if (queue->task) {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_PENDING,
+                                 "QRTR bus events already being waited for in queue %lu", queue_id);
+        g_object_unref (task);
+        return;
     }
 
-    /* type is something we handle, parse the packet */
-    node_id = GUINT32_FROM_LE (ctrl_packet.server.node);
-    port = GUINT32_FROM_LE (ctrl_packet.server.port);
-    service = GUINT32_FROM_LE (ctrl_packet.server.service);
-    version = GUINT32_FROM_LE (ctrl_packet.server.instance) & 0xff;
-    instance = GUINT32_FROM_LE (ctrl_packet.server.instance) >> 8;
-
-    if (type == QRTR_TYPE_DEL_SERVER) {
-        g_debug ("[qrtr] removed server on %u:%u -> service %u, version %u, instance %u",
-                 node_id, port, service, version, instance);
-        remove_service_info (self, node_id, port, service, version, instance);
-        return TRUE;
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
     }
 
-    g_assert (type == QRTR_TYPE_NEW_SERVER);
+    queue->task = task;
 
-    if (!node_id && !port && !service && !version && !instance) {
-        g_debug ("[qrtr] initial lookup finished");
-        initable_complete (self);
-        return TRUE;
+    if (cancellable) {
+        queue->cancellable_source = g_cancellable_source_new (cancellable);
+        g_source_set_callback (queue->cancellable_source, (GSourceFunc)event_queue_cancelled_cb, queue, NULL);
+        g_source_attach (queue->cancellable_source, g_task_get_context (task));
     }
 
-    g_debug ("[qrtr] added server on %u:%u -> service %u, version %u, instance %u",
-             node_id, port, service, version, instance);
-    add_service_info (self, node_id, port, service, version, instance);
-    return TRUE;
+    if (queue->n_events)
+        event_queue_schedule (queue);
 }
 
 /*****************************************************************************/
 
-QrtrNode *
-qrtr_bus_peek_node (QrtrBus *self,
-                    guint32  node_id)
+typedef struct {
+    guint32 node_id;
+    guint32 port;
+} ResolveResult;
+
+static void
+resolve_result_free (ResolveResult *result)
 {
-    GList *list_item;
+    g_slice_free (ResolveResult, result);
+}
 
-    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+/* All the sources of the waiter share the ownership of the task; whichever
+ * completes it first takes it, after removing the waiter. */
+typedef struct {
+    QrtrBus *self;
+    GTask   *task;
+    guint32  node_id;
+    guint32  service;
+    guint32  min_version;
+    guint32  max_version;
+    guint32  instance;
+    /* link in the queue of waiters of the service */
+    GList             *link;
+    QrtrDeadlineTimer *timer;
+    GSource *cancellable_source;
+} ResolveWaiter;
+
+static GTask *
+resolve_waiter_take_task (ResolveWaiter *waiter)
+{
+    GQueue *queue;
+    GTask  *task;
+
+    queue = g_hash_table_lookup (waiter->self->priv->resolve_waiters, GUINT_TO_POINTER (waiter->service));
+    g_assert (queue);
+    g_queue_delete_link (queue, waiter->link);
+    if (g_queue_is_empty (queue))
+        g_hash_table_remove (waiter->self->priv->resolve_waiters, GUINT_TO_POINTER (waiter->service));
+
+    if (waiter->timer)
+        qrtr_deadline_timer_remove (waiter->timer);
+    if (waiter->cancellable_source) {
+        g_source_destroy (waiter->cancellable_source);
+        g_source_unref (waiter->cancellable_source);
+    }
 
-    list_item = g_list_find_custom (self->priv->nodes, GUINT_TO_POINTER (node_id), (GCompareFunc)node_find_cmp);
-    return (list_item ? QRTR_NODE (list_item->data) : NULL);
+    task = waiter->task;
+    g_slice_free (ResolveWaiter, waiter);
+    return task;
 }
 
-QrtrNode *
-qrtr_bus_get_node (QrtrBus *self,
-                   guint32  node_id)
+static gboolean
+resolve_waiter_timeout_cb (ResolveWaiter *waiter)
 {
-    QrtrNode *node;
+    GTask   *task;
+    guint32  service;
 
-    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+    service = waiter->service;
+    task = resolve_waiter_take_task (waiter);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                             "QRTR service %u did not appear on the bus", service);
+    g_object_unref (task);
 
-    node = qrtr_bus_peek_node (self, node_id);
-    return (node ? g_object_ref (node) : NULL);
+    return G_SOURCE_REMOVE;
 }
 
-GList *
-qrtr_bus_peek_nodes (QrtrBus *self)
+static gboolean
+resolve_waiter_cancelled_cb (GCancellable  *cancellable,
+                             ResolveWaiter *waiter)
 {
-    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+    GTask *task;
 
-    return self->priv->nodes;
+    task = resolve_waiter_take_task (waiter);
+    g_task_return_error_if_cancelled (task);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
 }
 
-GList *
-qrtr_bus_get_nodes (QrtrBus *self)
+static void
+resolve_waiters_check (QrtrBus *self,
+                       guint32  node_id,
+                       guint32  port,
+                       guint32  service,
+                       guint32  version,
+                       guint32  instance)
 {
-    g_return_val_if_fail (QRTR_IS_BUS (self), NULL);
+    g_autoptr(GPtrArray) tasks = NULL;
+    GQueue              *queue;
+    GList               *l;
+    GList               *next;
+    guint                i;
+
+    queue = g_hash_table_lookup (self->priv->resolve_waiters, GUINT_TO_POINTER (service));
+    if (!queue)
+        return;
 
-    return g_list_copy_deep (self->priv->nodes, (GCopyFunc) g_object_ref, NULL);
-}
+    /* Take all the satisfied waiters before completing any, as completing a
+     * task may run user code that modifies the waiters. */
+    tasks = g_ptr_array_new ();
+    for (l = queue->head; l; l = next) {
+        ResolveWaiter *waiter = l->data;
 
-/*****************************************************************************/
+        /* the queue may be freed when its last waiter is taken */
+        next = l->next;
 
-typedef struct {
-    guint32  node_id;
-    guint    added_id;
-    GSource *timeout_source;
-} WaitForNodeContext;
+        if ((waiter->node_id != QRTR_BUS_NODE_ID_ANY && waiter->node_id != node_id) ||
+            version < waiter->min_version ||
+            version > waiter->max_version ||
+            (waiter->instance != QRTR_NODE_INSTANCE_ANY && waiter->instance != instance))
+            continue;
 
-static void
-wait_for_node_context_cleanup (QrtrBus            *self,
-                               WaitForNodeContext *ctx)
-{
-    if (ctx->timeout_source) {
-        g_source_destroy (ctx->timeout_source);
-        g_source_unref (ctx->timeout_source);
-        ctx->timeout_source = NULL;
+        g_ptr_array_add (tasks, resolve_waiter_take_task (waiter));
     }
 
-    if (ctx->added_id) {
-        g_signal_handler_disconnect (self, ctx->added_id);
-        ctx->added_id = 0;
+    for (i = 0; i < tasks->len; i++) {
+        GTask         *task;
+        ResolveResult *result;
+
+        task = g_ptr_array_index (tasks, i);
+        result = g_slice_new (ResolveResult);
+        result->node_id = node_id;
+        result->port = port;
+        g_task_return_pointer (task, result, (GDestroyNotify) resolve_result_free);
+        g_object_unref (task);
     }
 }
 
 static void
-wait_for_node_context_free (WaitForNodeContext *ctx)
+resolve_waiters_cancel_all (QrtrBus *self)
 {
-    g_assert (!ctx->added_id);
-    g_assert (!ctx->timeout_source);
-    g_slice_free (WaitForNodeContext, ctx);
-}
+    g_autoptr(GPtrArray) tasks = NULL;
+    GHashTableIter       iter;
+    GQueue              *queue;
+    guint                i;
+
+    tasks = g_ptr_array_new ();
+    while (g_hash_table_size (self->priv->resolve_waiters) > 0) {
+        g_hash_table_iter_init (&iter, self->priv->resolve_waiters);
+        g_hash_table_iter_next (&iter, NULL, (gpointer *)&queue);
+        g_ptr_array_add (tasks, resolve_waiter_take_task (g_queue_peek_head (queue)));
+    }
 
-QrtrNode *
-qrtr_bus_wait_for_node_finish (QrtrBus       *self,
-                               GAsyncResult  *res,
-                               GError       **error)
-{
-    return g_task_propagate_pointer (G_TASK (res), error);
+    for (i = 0; i < tasks->len; i++) {
+        GTask *task = g_ptr_array_index (tasks, i);
+
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                                 "QRTR bus is closed");
+        g_object_unref (task);
+    }
 }
 
 static gboolean
-wait_for_node_timeout_cb (GTask *task)
+resolve_lookup (QrtrBus *self,
+                guint32  node_id,
+                guint32  service,
+                guint32  min_version,
+                guint32  max_version,
+                guint32  instance,
+                guint32 *found_node_id,
+                guint32 *found_port)
 {
-    QrtrBus            *self;
-    WaitForNodeContext *ctx;
+    NodeRecord          *record;
+    QrtrNodeServiceInfo *info;
 
-    self = g_task_get_source_object (task);
-    ctx  = g_task_get_task_data (task);
+    if (node_id == QRTR_BUS_NODE_ID_ANY)
+        return qrtr_bus_lookup_service (self, service, min_version, max_version, instance, found_node_id, found_port);
 
-    /* cleanup the context right away, so that we take exclusive ownership
-     * of the task */
-    wait_for_node_context_cleanup (self, ctx);
+    record = g_hash_table_lookup (self->priv->node_records, GUINT_TO_POINTER (node_id));
+    if (!record)
+        return FALSE;
 
-    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
-                             "QRTR node %u did not appear on the bus", ctx->node_id);
-    g_object_unref (task);
+    info = node_record_peek_service_info (record, service, min_version, max_version, instance);
+    if (!info)
+        return FALSE;
 
-    return G_SOURCE_REMOVE;
+    *found_node_id = node_id;
+    *found_port = qrtr_node_service_info_get_port (info);
+    return TRUE;
 }
 
-static void
-wait_for_node_added_cb (QrtrBus *self,
-                        guint    node_id,
-                        GTask   *task)
+gboolean
+qrtr_bus_resolve_service_finish (QrtrBus       *self,
+                                 GAsyncResult  *res,
+                                 guint32       *node_id,
+                                 guint32       *port,
+                                 QrtrClient   **client,
+                                 GError       **error)
 {
-    WaitForNodeContext *ctx;
-    QrtrNode           *node;
+    ResolveResult *result;
 
-    ctx = g_task_get_task_data (task);
-
-    /* not the one we want, ignore */
-    if (node_id != ctx->node_id)
-        return;
+    result = g_task_propagate_pointer (G_TASK (res), error);
+    if (!result)
+        return FALSE;
 
-    /* cleanup the context right away, so that we take exclusive ownership
-     * of the task */
-    wait_for_node_context_cleanup (self, ctx);
+    if (client) {
+        g_autoptr(QrtrNode) node = NULL;
+
+        node = qrtr_bus_get_node (self, result->node_id);
+        if (!node) {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                         "QRTR node %u was removed from the bus", result->node_id);
+            resolve_result_free (result);
+            return FALSE;
+        }
+
+        *client = qrtr_client_new (node, result->port, NULL, error);
+        if (!*client) {
+            resolve_result_free (result);
+            return FALSE;
+        }
+    }
 
-    /* get a full node reference */
-    node = qrtr_bus_get_node (self, node_id);
-    g_task_return_pointer (task, node, g_object_unref);
-    g_object_unref (task);
+    if (node_id)
+        *node_id = result->node_id;
+    if (port)
+        *port = result->port;
+    resolve_result_free (result);
+    return TRUE;
 }
 
 void
-qrtr_bus_wait_for_node (QrtrBus             *self,
-                        guint32              node_id,
-                        guint                timeout_ms,
-                        GCancellable        *cancellable,
-                        GAsyncReadyCallback  callback,
-                        gpointer             user_data)
+qrtr_bus_resolve_service_until (QrtrBus             *self,
+                                guint32              node_id,
+                                guint32              service,
+                                guint32              min_version,
+                                guint32              max_version,
+                                guint32              instance,
+                                gint64               deadline,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
 {
-    GTask              *task;
-    WaitForNodeContext *ctx;
-    QrtrNode           *existing_node;
+    GTask         *task;
+    ResolveWaiter *waiter;
+    ResolveResult *result;
+    GQueue        *queue;
+    guint32        found_node_id;
+    guint32        found_port;
 
     g_return_if_fail (QRTR_IS_BUS (self));
-    g_return_if_fail (timeout_ms > 0);
 
     task = g_task_new (self, cancellable, callback, user_data);
 
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
+    }
+
     /* Nothing to do if it already exists */
-    existing_node = qrtr_bus_get_node (self, node_id);
-    if (existing_node) {
-        g_task_return_pointer (task, existing_node, (GDestroyNotify)g_object_unref);
+    if (resolve_lookup (self, node_id, service, min_version, max_version, instance,
+                        &found_node_id, &found_port)) {
+        result = g_slice_new (ResolveResult);
+        result->node_id = found_node_id;
+        result->port = found_port;
+        g_task_return_pointer (task, result, (GDestroyNotify) resolve_result_free);
         g_object_unref (task);
         return;
     }
 
-    /* The ownership of the task is shared between the signal handler and the timeout;
-     * we need to make sure that we cancel the other one if we're completing the task
-     * from one of them. */
-    ctx = g_slice_new0 (WaitForNodeContext);
-    ctx->node_id = node_id;
+    waiter = g_slice_new0 (ResolveWaiter);
+    waiter->self = self;
+    waiter->task = task;
+    waiter->node_id = node_id;
+    waiter->service = service;
+    waiter->min_version = min_version;
+    waiter->max_version = max_version;
+    waiter->instance = instance;
+
+    queue = g_hash_table_lookup (self->priv->resolve_waiters, GUINT_TO_POINTER (service));
+    if (!queue) {
+        queue = g_queue_new ();
+        g_hash_table_insert (self->priv->resolve_waiters, GUINT_TO_POINTER (service), queue);
+    }
+    g_queue_push_tail (queue, waiter);
+    waiter->link = g_queue_peek_tail_link (queue);
+
+    waiter->timer = qrtr_deadline_timer_add (g_main_context_get_thread_default (), deadline,
+                                             (GSourceFunc) resolve_waiter_timeout_cb, waiter);
 
-    /* Monitor added nodes */
-    ctx->added_id = g_signal_connect (self,
-                                      QRTR_BUS_SIGNAL_NODE_ADDED,
-                                      G_CALLBACK (wait_for_node_added_cb),
-                                      task);
+    if (cancellable) {
+        waiter->cancellable_source = g_cancellable_source_new (cancellable);
+        g_source_set_callback (waiter->cancellable_source, (GSourceFunc) resolve_waiter_cancelled_cb, waiter, NULL);
+        g_source_attach (waiter->cancellable_source, g_main_context_get_thread_default ());
+    }
+}
 
-    /* Setup timeout for the operation */
-    ctx->timeout_source = g_timeout_source_new (timeout_ms);
-    g_source_set_callback (ctx->timeout_source, (GSourceFunc)wait_for_node_timeout_cb, task, NULL);
-    g_source_attach (ctx->timeout_source, g_main_context_get_thread_default ());
+void
+qrtr_bus_resolve_service (QrtrBus             *self,
+                          guint32              node_id,
+                          guint32              service,
+                          guint32              min_version,
+                          guint32              max_version,
+                          guint32              instance,
+                          guint                timeout_ms,
+                          GCancellable        *cancellable,
+                          GAsyncReadyCallback  callback,
+                          gpointer             user_data)
+{
+    g_return_if_fail (timeout_ms > 0);
 
-    g_task_set_task_data (task, ctx, (GDestroyNotify)wait_for_node_context_free);
+    qrtr_bus_resolve_service_until (self, node_id, service, min_version, max_version, instance,
+                                    qrtr_deadline_from_timeout (timeout_ms),
+                                    cancellable, callback, user_data);
 }
 
 /*****************************************************************************/
 
 static gboolean
-send_new_lookup_ctrl_packet (QrtrBus  *self,
-                             GError  **error)
+send_lookup_ctrl_packet (QrtrBus  *self,
+                         guint32   cmd,
+                         GError  **error)
 {
     struct qrtr_ctrl_pkt ctl_packet;
     struct sockaddr_qrtr addr;
@@ -397,7 +1602,7 @@ send_new_lookup_ctrl_packet (QrtrBus  *self,
     addr.sq_port = QRTR_PORT_CTRL;
 
     memset (&ctl_packet, 0, sizeof (ctl_packet));
-    ctl_packet.cmd = GUINT32_TO_LE (QRTR_TYPE_NEW_LOOKUP);
+    ctl_packet.cmd = GUINT32_TO_LE (cmd);
 
     rc = sendto (sockfd, (void *)&ctl_packet, sizeof (ctl_packet),
                  0, (struct sockaddr *)&addr, sizeof (addr));
@@ -405,22 +1610,25 @@ send_new_lookup_ctrl_packet (QrtrBus  *self,
         g_set_error (error,
                      G_IO_ERROR,
                      g_io_error_from_errno (errno),
-                     "Failed to send lookup control packet");
+                     "Failed to send %s control packet",
+                     cmd == QRTR_TYPE_NEW_LOOKUP ? "lookup" : "lookup removal");
         return FALSE;
     }
 
     return TRUE;
 }
 
-static void
-setup_socket_source (QrtrBus *self)
+static gboolean
+setup_socket_watch (QrtrBus  *self,
+                    GError  **error)
 {
-    self->priv->source = g_socket_create_source (self->priv->socket, G_IO_IN, NULL);
-    g_source_set_callback (self->priv->source,
-                           (GSourceFunc) qrtr_ctrl_message_cb,
-                           self,
-                           NULL);
-    g_source_attach (self->priv->source, g_main_context_get_thread_default ());
+    self->priv->watch = qrtr_reactor_watch_add (g_main_context_get_thread_default (),
+                                                g_socket_get_fd (self->priv->socket),
+                                                G_PRIORITY_DEFAULT,
+                                                (QrtrReactorFunc) qrtr_ctrl_message_cb,
+                                                self,
+                                                error);
+    return !!self->priv->watch;
 }
 
 static gboolean
@@ -444,13 +1652,20 @@ common_init (QrtrBus  *self,
 
     g_socket_set_timeout (self->priv->socket, 0);
 
-    if (!send_new_lookup_ctrl_packet (self, error)) {
+    if (self->priv->receive_buffer_size) {
+        gint size = (gint) MIN (self->priv->receive_buffer_size, (guint) G_MAXINT);
+
+        if (setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof (size)) < 0)
+            g_warning ("[qrtr] couldn't set receive buffer size to %u bytes: %s",
+                       self->priv->receive_buffer_size, g_strerror (errno));
+    }
+
+    if (!send_lookup_ctrl_packet (self, QRTR_TYPE_NEW_LOOKUP, error)) {
         close (fd);
         return FALSE;
     }
 
-    setup_socket_source (self);
-    return TRUE;
+    return setup_socket_watch (self, error);
 }
 
 /*****************************************************************************/
@@ -558,6 +1773,232 @@ qrtr_bus_new (guint                lookup_timeout_ms,
                                 NULL);
 }
 
+/*****************************************************************************/
+/* Shared bus, one per main context */
+
+/* The shared bus is only handed out once its initial lookup is done, as its
+ * users may not agree on how long to wait for it; each of them waits as long
+ * as given by its own timeout. */
+#define DEFAULT_BUS_LOOKUP_TIMEOUT_MS G_MAXUINT
+
+typedef struct {
+    GMainContext *context;
+    gboolean      creating;
+    /* The shared bus, not owned, so that it's disposed once all its users
+     * release it; set once created */
+    GWeakRef      bus;
+    /* DefaultWaiters waiting for the bus to be created; only used from the
+     * thread running the context */
+    GQueue        waiters;
+} DefaultBus;
+
+typedef struct {
+    DefaultBus *shared;
+    GTask      *task;
+    GList       link;
+    GSource    *cancellable_source;
+    GSource    *timeout_source;
+} DefaultWaiter;
+
+/* GMainContext -> DefaultBus */
+G_LOCK_DEFINE_STATIC (default_buses);
+static GHashTable *default_buses;
+
+static void
+default_bus_free (DefaultBus *shared)
+{
+    g_assert (g_queue_is_empty (&shared->waiters));
+    g_weak_ref_clear (&shared->bus);
+    g_main_context_unref (shared->context);
+    g_slice_free (DefaultBus, shared);
+}
+
+static void
+default_bus_unregister (DefaultBus *shared)
+{
+    G_LOCK (default_buses);
+    if (g_hash_table_lookup (default_buses, shared->context) == shared)
+        g_hash_table_remove (default_buses, shared->context);
+    G_UNLOCK (default_buses);
+}
+
+static void
+default_bus_gone (DefaultBus *shared,
+                  GObject    *where_the_object_was)
+{
+    default_bus_unregister (shared);
+    default_bus_free (shared);
+}
+
+static GTask *
+default_waiter_take_task (DefaultWaiter *waiter)
+{
+    GTask *task;
+
+    g_queue_unlink (&waiter->shared->waiters, &waiter->link);
+    if (waiter->cancellable_source) {
+        g_source_destroy (waiter->cancellable_source);
+        g_source_unref (waiter->cancellable_source);
+    }
+    if (waiter->timeout_source) {
+        g_source_destroy (waiter->timeout_source);
+        g_source_unref (waiter->timeout_source);
+    }
+
+    task = waiter->task;
+    g_slice_free (DefaultWaiter, waiter);
+    return task;
+}
+
+static gboolean
+default_waiter_cancelled_cb (DefaultWaiter *waiter)
+{
+    GTask *task;
+
+    /* the bus creation goes on for the other waiters */
+    task = default_waiter_take_task (waiter);
+    g_task_return_error_if_cancelled (task);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+default_waiter_timeout_cb (DefaultWaiter *waiter)
+{
+    GTask *task;
+
+    /* the bus creation goes on for the other waiters */
+    task = default_waiter_take_task (waiter);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+                             "Timed out waiting for the initial bus lookup");
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+default_bus_new_ready (GObject      *source,
+                       GAsyncResult *res,
+                       DefaultBus   *shared)
+{
+    g_autoptr(GError)  error = NULL;
+    QrtrBus           *bus;
+
+    bus = qrtr_bus_new_finish (res, &error);
+    if (bus) {
+        G_LOCK (default_buses);
+        g_weak_ref_set (&shared->bus, bus);
+        shared->creating = FALSE;
+        G_UNLOCK (default_buses);
+        g_object_weak_ref (G_OBJECT (bus), (GWeakNotify) default_bus_gone, shared);
+    } else {
+        /* the next caller tries again */
+        default_bus_unregister (shared);
+    }
+
+    while (!g_queue_is_empty (&shared->waiters)) {
+        GTask *task;
+
+        task = default_waiter_take_task (g_queue_peek_head (&shared->waiters));
+        if (bus)
+            g_task_return_pointer (task, g_object_ref (bus), (GDestroyNotify)g_object_unref);
+        else
+            g_task_return_error (task, g_error_copy (error));
+        g_object_unref (task);
+    }
+
+    /* if all the waiters are gone, this disposes the bus and frees the
+     * shared info right away */
+    if (bus)
+        g_object_unref (bus);
+    else
+        default_bus_free (shared);
+}
+
+QrtrBus *
+qrtr_bus_get_default_finish (GAsyncResult  *res,
+                             GError       **error)
+{
+    return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+void
+qrtr_bus_get_default (guint                lookup_timeout_ms,
+                      GCancellable        *cancellable,
+                      GAsyncReadyCallback  callback,
+                      gpointer             user_data)
+{
+    GTask         *task;
+    GMainContext  *context;
+    DefaultBus    *shared;
+    DefaultWaiter *waiter;
+    QrtrBus       *bus = NULL;
+    gboolean       create = FALSE;
+
+    task = g_task_new (NULL, cancellable, callback, user_data);
+
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
+    }
+
+    context = g_main_context_ref_thread_default ();
+
+    G_LOCK (default_buses);
+    if (!default_buses)
+        default_buses = g_hash_table_new (g_direct_hash, g_direct_equal);
+    shared = g_hash_table_lookup (default_buses, context);
+    if (shared && !shared->creating) {
+        /* if the bus is being disposed, the old shared info is freed once
+         * it's gone */
+        bus = g_weak_ref_get (&shared->bus);
+        if (!bus)
+            shared = NULL;
+    }
+    if (!shared) {
+        shared = g_slice_new0 (DefaultBus);
+        shared->context = g_main_context_ref (context);
+        shared->creating = TRUE;
+        g_weak_ref_init (&shared->bus, NULL);
+        g_hash_table_insert (default_buses, context, shared);
+        create = TRUE;
+    }
+    G_UNLOCK (default_buses);
+
+    g_main_context_unref (context);
+
+    /* Already created, join right away */
+    if (bus) {
+        g_task_return_pointer (task, bus, (GDestroyNotify)g_object_unref);
+        g_object_unref (task);
+        return;
+    }
+
+    waiter = g_slice_new0 (DefaultWaiter);
+    waiter->shared = shared;
+    waiter->task = task;
+    waiter->link.data = waiter;
+    g_queue_push_tail_link (&shared->waiters, &waiter->link);
+
+    /* Release the waiter as soon as the operation is cancelled */
+    if (cancellable) {
+        waiter->cancellable_source = g_cancellable_source_new (cancellable);
+        g_source_set_callback (waiter->cancellable_source, (GSourceFunc)default_waiter_cancelled_cb, waiter, NULL);
+        g_source_attach (waiter->cancellable_source, g_main_context_get_thread_default ());
+    }
+
+    /* Each waiter gives up on its own */
+    if (lookup_timeout_ms) {
+        waiter->timeout_source = g_timeout_source_new (lookup_timeout_ms);
+        g_source_set_callback (waiter->timeout_source, (GSourceFunc)default_waiter_timeout_cb, waiter, NULL);
+        g_source_attach (waiter->timeout_source, g_main_context_get_thread_default ());
+    }
+
+    if (create)
+        qrtr_bus_new (DEFAULT_BUS_LOOKUP_TIMEOUT_MS, NULL, (GAsyncReadyCallback) default_bus_new_ready, shared);
+}
+
 /*****************************************************************************/
 
 static void
@@ -566,6 +2007,15 @@ qrtr_bus_init (QrtrBus *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               QRTR_TYPE_BUS,
                                               QrtrBusPrivate);
+
+    self->priv->node_records = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                      NULL, (GDestroyNotify)node_record_free);
+    self->priv->service_table = qrtr_service_table_new ();
+    g_hook_list_init (&self->priv->service_hooks, sizeof (ServiceHook));
+    self->priv->node_waiters = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                      NULL, (GDestroyNotify)g_queue_free);
+    self->priv->resolve_waiters = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                         NULL, (GDestroyNotify)g_queue_free);
 }
 
 static void
@@ -580,6 +2030,9 @@ set_property (GObject      *object,
     case PROP_LOOKUP_TIMEOUT:
         self->priv->lookup_timeout = g_value_get_uint (value);
         break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+        self->priv->receive_buffer_size = g_value_get_uint (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -598,6 +2051,9 @@ get_property (GObject    *object,
     case PROP_LOOKUP_TIMEOUT:
         g_value_set_uint (value, self->priv->lookup_timeout);
         break;
+    case PROP_RECEIVE_BUFFER_SIZE:
+        g_value_set_uint (value, self->priv->receive_buffer_size);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -612,23 +2068,49 @@ dispose (GObject *object)
     g_assert (!self->priv->init_task);
     g_assert (!self->priv->init_timeout_source);
 
-    if (self->priv->source) {
-        g_source_destroy (self->priv->source);
-        g_source_unref (self->priv->source);
-        self->priv->source = NULL;
-    }
+    g_clear_pointer (&self->priv->watch, qrtr_reactor_watch_remove);
 
     if (self->priv->socket) {
         g_socket_close (self->priv->socket, NULL);
         g_clear_object (&self->priv->socket);
     }
 
-    g_list_free_full (self->priv->nodes, g_object_unref);
-    self->priv->nodes = NULL;
+    g_clear_pointer (&self->priv->nodes, g_list_free);
+    if (self->priv->node_records)
+        g_hash_table_remove_all (self->priv->node_records);
+
+    g_clear_pointer (&self->priv->resync_seen, g_hash_table_unref);
+
+    if (self->priv->service_hooks.is_setup)
+        g_hook_list_clear (&self->priv->service_hooks);
+    /* pending operations may add queues again while being completed */
+    while (self->priv->event_queues)
+        g_hash_table_unref (g_steal_pointer (&self->priv->event_queues));
+    g_clear_pointer (&self->priv->services_snapshot, g_array_unref);
+
+    if (self->priv->node_waiters) {
+        node_waiters_cancel_all (self);
+        g_clear_pointer (&self->priv->node_waiters, g_hash_table_unref);
+    }
+
+    if (self->priv->resolve_waiters) {
+        resolve_waiters_cancel_all (self);
+        g_clear_pointer (&self->priv->resolve_waiters, g_hash_table_unref);
+    }
 
     G_OBJECT_CLASS (qrtr_bus_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    QrtrBus *self = QRTR_BUS (object);
+
+    qrtr_service_table_free (self->priv->service_table);
+
+    G_OBJECT_CLASS (qrtr_bus_parent_class)->finalize (object);
+}
+
 static void
 async_initable_iface_init (GAsyncInitableIface *iface)
 {
@@ -646,6 +2128,7 @@ qrtr_bus_class_init (QrtrBusClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /**
      * QrtrBus:lookup-timeout:
@@ -662,6 +2145,21 @@ qrtr_bus_class_init (QrtrBusClass *klass)
                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
     g_object_class_install_property (object_class, PROP_LOOKUP_TIMEOUT, properties[PROP_LOOKUP_TIMEOUT]);
 
+    /**
+     * QrtrBus:receive-buffer-size:
+     *
+     * Since: 1.4
+     */
+    properties[PROP_RECEIVE_BUFFER_SIZE] =
+        g_param_spec_uint (QRTR_BUS_RECEIVE_BUFFER_SIZE,
+                           "receive buffer size",
+                           "Size in bytes of the receive buffer of the control socket, or 0 to use the system default",
+                           0,
+                           G_MAXUINT,
+                           0,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_RECEIVE_BUFFER_SIZE, properties[PROP_RECEIVE_BUFFER_SIZE]);
+
     /**
      * QrtrBus::node-added:
      * @self: the #QrtrBus
@@ -63,6 +63,15 @@ struct _QrtrBusClass {
 GType qrtr_bus_get_type (void);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (QrtrBus, g_object_unref)
 
+/**
+ * QRTR_BUS_NODE_ID_ANY:
+ *
+ * Wildcard node ID, to accept services in any node.
+ *
+ * Since: 1.4
+ */
+#define QRTR_BUS_NODE_ID_ANY G_MAXUINT32
+
 /**
  * QRTR_BUS_LOOKUP_TIMEOUT:
  *
@@ -72,6 +81,15 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC (QrtrBus, g_object_unref)
  */
 #define QRTR_BUS_LOOKUP_TIMEOUT "lookup-timeout"
 
+/**
+ * QRTR_BUS_RECEIVE_BUFFER_SIZE:
+ *
+ * Symbol defining the #QrtrBus:receive-buffer-size property.
+ *
+ * Since: 1.4
+ */
+#define QRTR_BUS_RECEIVE_BUFFER_SIZE "receive-buffer-size"
+
 /**
  * QRTR_BUS_SIGNAL_NODE_ADDED:
  *
@@ -132,6 +150,62 @@ void qrtr_bus_new (guint                lookup_timeout_ms,
 QrtrBus *qrtr_bus_new_finish (GAsyncResult  *res,
                               GError       **error);
 
+/**
+ * qrtr_bus_get_default:
+ * @lookup_timeout_ms: the timeout, in milliseconds, to wait for the initial bus
+ *   lookup to complete, if the shared bus is still being created. A zero
+ *   timeout waits as long as the lookup takes.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @callback: a #GAsyncReadyCallback to call when the bus is available.
+ * @user_data: the data to pass to callback function.
+ *
+ * Asynchronously gets the #QrtrBus shared by all the users in the
+ * thread-default main context of the caller.
+ *
+ * The first caller creates the bus, as qrtr_bus_new() does; callers that come
+ * while it is being created wait for the same initial lookup, and later
+ * callers get the existing bus right away, so that the different users in a
+ * process don't each open their own control socket, request their own lookup
+ * and keep their own copy of the bus state. The bus is disposed once all the
+ * users release their references, and the next caller creates a new one.
+ *
+ * The shared bus is only handed out once its initial lookup is complete,
+ * whatever the timeouts given by its users, so it always knows about all the
+ * nodes in the bus. Each caller waits for the lookup at most
+ * @lookup_timeout_ms, and gets a %G_IO_ERROR_TIMED_OUT error afterwards,
+ * while the creation goes on for any other caller. Users which don't need
+ * the initial lookup should create their own bus with qrtr_bus_new()
+ * instead.
+ *
+ * Cancelling @cancellable only stops waiting for the bus in this call, the
+ * creation goes on for any other caller. If the creation fails, all the
+ * callers waiting for it get the error.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * thread-default main context of the caller. You can then call
+ * qrtr_bus_get_default_finish() to get the result of the operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_get_default (guint                lookup_timeout_ms,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data);
+
+/**
+ * qrtr_bus_get_default_finish:
+ * @res: a #GAsyncResult.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with qrtr_bus_get_default().
+ *
+ * Returns: (transfer full): the shared #QrtrBus, or %NULL if @error is set.
+ *
+ * Since: 1.4
+ */
+QrtrBus *qrtr_bus_get_default_finish (GAsyncResult  *res,
+                                      GError       **error);
+
 /**
  * qrtr_bus_peek_node:
  * @self: a #QrtrBus.
@@ -196,6 +270,324 @@ GList *qrtr_bus_peek_nodes (QrtrBus *self);
  */
 GList *qrtr_bus_get_nodes (QrtrBus *self);
 
+/**
+ * qrtr_bus_lookup_service:
+ * @self: a #QrtrBus.
+ * @service: a service number.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ * @node_id: (out)(optional): return location for the node ID, or %NULL.
+ * @port: (out)(optional): return location for the port number, or %NULL.
+ *
+ * Looks up a server for the given service number in any of the nodes of the
+ * bus, with a version in the [@min_version, @max_version] range and matching
+ * the given @instance.
+ *
+ * If multiple matching servers are registered, this method returns the one
+ * with the highest version number; if several nodes expose that same version,
+ * the one in the node with the lowest node ID is returned.
+ *
+ * Returns: %TRUE if a server was found and @node_id and @port are set,
+ *  %FALSE otherwise.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_bus_lookup_service (QrtrBus *self,
+                                  guint32  service,
+                                  guint32  min_version,
+                                  guint32  max_version,
+                                  guint32  instance,
+                                  guint32 *node_id,
+                                  guint32 *port);
+
+/**
+ * QrtrBusServiceRecord:
+ * @node_id: the node ID.
+ * @service: the service number.
+ * @port: the port number.
+ * @version: the version number.
+ * @instance: the instance number.
+ *
+ * A server known in the bus, as reported by qrtr_bus_query_services().
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    guint32 node_id;
+    guint32 service;
+    guint32 port;
+    guint32 version;
+    guint32 instance;
+} QrtrBusServiceRecord;
+
+/**
+ * QrtrBusServiceFilter:
+ * @node_id: the node ID, or %QRTR_BUS_NODE_ID_ANY.
+ * @services: (array length=n_services)(nullable): the accepted service
+ *  numbers, or %NULL to accept any service.
+ * @n_services: the number of elements in @services.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ *
+ * The conditions a server must fulfill to be reported by
+ * qrtr_bus_query_services().
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    guint32        node_id;
+    const guint32 *services;
+    guint          n_services;
+    guint32        min_version;
+    guint32        max_version;
+    guint32        instance;
+} QrtrBusServiceFilter;
+
+/**
+ * qrtr_bus_query_services:
+ * @self: a #QrtrBus.
+ * @filter: a #QrtrBusServiceFilter.
+ * @results: (element-type QrtrBusServiceRecord): a #GArray of
+ *  #QrtrBusServiceRecord elements where to append the results.
+ *
+ * Looks up all the servers known in the bus that match @filter, e.g. all the
+ * servers with a version greater than or equal to 2, or all the servers of a
+ * given set of services in a given node.
+ *
+ * The servers are kept in a table with one array per field, so that queries
+ * are linear scans over contiguous memory regardless of how the servers are
+ * distributed among nodes. The results are appended to @results, which may
+ * be reused across queries to avoid allocations, in no particular order.
+ *
+ * Returns: the number of records appended to @results.
+ *
+ * Since: 1.4
+ */
+guint qrtr_bus_query_services (QrtrBus                    *self,
+                               const QrtrBusServiceFilter *filter,
+                               GArray                     *results);
+
+/**
+ * QrtrBusServiceFunc:
+ * @self: a #QrtrBus.
+ * @added: %TRUE if the server was added, %FALSE if it was removed.
+ * @record: the #QrtrBusServiceRecord of the server.
+ * @user_data: the user data given to qrtr_bus_subscribe_services().
+ *
+ * The type of the functions that get notified of the changes in the servers
+ * of the bus.
+ *
+ * A server announced again in the same port with different details is
+ * notified as removed and then added.
+ *
+ * Since: 1.4
+ */
+typedef void (* QrtrBusServiceFunc) (QrtrBus                    *self,
+                                     gboolean                    added,
+                                     const QrtrBusServiceRecord *record,
+                                     gpointer                    user_data);
+
+/**
+ * qrtr_bus_subscribe_services:
+ * @self: a #QrtrBus.
+ * @callback: the function to call when servers are added or removed.
+ * @user_data: the data to pass to @callback.
+ * @destroy: (nullable): the function to free @user_data, or %NULL.
+ * @subscription_id: (out): return location for the subscription id.
+ *
+ * Gets a snapshot of all the servers known in the bus, and subscribes to the
+ * changes that happen afterwards, in a single step. Replaying the changes
+ * notified to @callback on top of the snapshot always gives the current
+ * state of the bus, with no change missing or counted twice.
+ *
+ * The snapshot is shared with any other caller until the bus changes, so it
+ * must not be modified. The nodes in the bus are the ones with at least one
+ * server in the snapshot.
+ *
+ * The subscription is kept until qrtr_bus_unsubscribe_services() is called,
+ * or until the bus is disposed.
+ *
+ * Returns: (transfer full)(element-type QrtrBusServiceRecord): a #GArray of
+ *  #QrtrBusServiceRecord elements, that should be freed with g_array_unref().
+ *
+ * Since: 1.4
+ */
+GArray *qrtr_bus_subscribe_services (QrtrBus            *self,
+                                     QrtrBusServiceFunc  callback,
+                                     gpointer            user_data,
+                                     GDestroyNotify      destroy,
+                                     gulong             *subscription_id);
+
+/**
+ * qrtr_bus_unsubscribe_services:
+ * @self: a #QrtrBus.
+ * @subscription_id: a subscription id, as given by
+ *  qrtr_bus_subscribe_services().
+ *
+ * Removes a subscription to the changes in the servers of the bus. The
+ * callback of the subscription is no longer called after this method returns.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_unsubscribe_services (QrtrBus *self,
+                                    gulong   subscription_id);
+
+/**
+ * QrtrBusEventType:
+ * @QRTR_BUS_EVENT_TYPE_NODE_ADDED: a node was added to the bus.
+ * @QRTR_BUS_EVENT_TYPE_NODE_REMOVED: a node was removed from the bus.
+ * @QRTR_BUS_EVENT_TYPE_SERVICE_ADDED: a server was added to the bus.
+ * @QRTR_BUS_EVENT_TYPE_SERVICE_REMOVED: a server was removed from the bus.
+ *
+ * The type of a change in the bus.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+    QRTR_BUS_EVENT_TYPE_NODE_ADDED,
+    QRTR_BUS_EVENT_TYPE_NODE_REMOVED,
+    QRTR_BUS_EVENT_TYPE_SERVICE_ADDED,
+    QRTR_BUS_EVENT_TYPE_SERVICE_REMOVED
+} QrtrBusEventType;
+
+/**
+ * QrtrBusEvent:
+ * @type: the #QrtrBusEventType.
+ * @record: the server added or removed; for node events, only the @node_id
+ *  field of the record is set.
+ *
+ * A change in the bus, as reported by qrtr_bus_next_events_finish().
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    QrtrBusEventType     type;
+    QrtrBusServiceRecord record;
+} QrtrBusEvent;
+
+/**
+ * QrtrBusEventOverflow:
+ * @QRTR_BUS_EVENT_OVERFLOW_DROP_OLDEST: drop the oldest queued event to make
+ *  room for the new one.
+ * @QRTR_BUS_EVENT_OVERFLOW_DROP_NEWEST: drop the new event.
+ *
+ * What to do with a new event when the event queue is full.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+    QRTR_BUS_EVENT_OVERFLOW_DROP_OLDEST,
+    QRTR_BUS_EVENT_OVERFLOW_DROP_NEWEST
+} QrtrBusEventOverflow;
+
+/**
+ * qrtr_bus_add_event_queue:
+ * @self: a #QrtrBus.
+ * @max_events: the maximum number of events kept, greater than 0.
+ * @overflow: a #QrtrBusEventOverflow.
+ *
+ * Adds a queue of the changes in the bus, from which qrtr_bus_next_events()
+ * takes them. Every consumer of the bus should add its own queue: each one
+ * gets all the changes happening after it was added, regardless of how fast
+ * the other consumers take theirs.
+ *
+ * When more than @max_events are pending in the queue, events are dropped as
+ * given by @overflow, and the number of dropped events is reported with the
+ * next batch, so that the consumer may resync its view of the bus, e.g. with
+ * qrtr_bus_query_services().
+ *
+ * The queue is kept until qrtr_bus_remove_event_queue() is called, or until
+ * the bus is disposed.
+ *
+ * Returns: the id of the queue.
+ *
+ * Since: 1.4
+ */
+gulong qrtr_bus_add_event_queue (QrtrBus              *self,
+                                 guint                 max_events,
+                                 QrtrBusEventOverflow  overflow);
+
+/**
+ * qrtr_bus_remove_event_queue:
+ * @self: a #QrtrBus.
+ * @queue_id: a queue id, as given by qrtr_bus_add_event_queue().
+ *
+ * Removes a queue of changes in the bus, discarding all its pending events,
+ * and completes the pending qrtr_bus_next_events() operation on it, if any,
+ * with %G_IO_ERROR_CLOSED.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_remove_event_queue (QrtrBus *self,
+                                  gulong   queue_id);
+
+/**
+ * qrtr_bus_next_events:
+ * @self: a #QrtrBus.
+ * @queue_id: a queue id, as given by qrtr_bus_add_event_queue().
+ * @cancellable: a #GCancellable, or #NULL.
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Asynchronously waits for changes in the bus, and takes all the pending
+ * ones from the given event queue.
+ *
+ * Changes happening in the same main loop iteration are reported together,
+ * in the order they happened. Only one operation may be pending at a time in
+ * each queue; other operations on the same queue fail with
+ * %G_IO_ERROR_PENDING.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * qrtr_bus_next_events_finish() to get the result of the operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_next_events (QrtrBus             *self,
+                           gulong               queue_id,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data);
+
+/**
+ * qrtr_bus_next_events_finish:
+ * @self: a #QrtrBus.
+ * @res: a #GAsyncResult.
+ * @n_dropped: (out)(optional): return location for the number of events
+ *  dropped since the previous batch, or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with qrtr_bus_next_events().
+ *
+ * Returns: (transfer full)(element-type QrtrBusEvent): a #GArray of
+ *  #QrtrBusEvent elements, that should be freed with g_array_unref(), or
+ *  %NULL if @error is set.
+ *
+ * Since: 1.4
+ */
+GArray *qrtr_bus_next_events_finish (QrtrBus       *self,
+                                     GAsyncResult  *res,
+                                     guint         *n_dropped,
+                                     GError       **error);
+
+/**
+ * qrtr_bus_get_dropped_packets:
+ * @self: a #QrtrBus.
+ *
+ * Gets the number of control packets that the kernel dropped because the
+ * receive queue of the bus socket was full.
+ *
+ * Whenever new drops are detected the bus automatically requests a new full
+ * lookup to the QRTR name service, and reconciles its view of the nodes and
+ * services with the result, so that no stale entries are kept.
+ *
+ * Returns: the number of dropped control packets.
+ *
+ * Since: 1.4
+ */
+guint64 qrtr_bus_get_dropped_packets (QrtrBus *self);
+
 /**
  * qrtr_bus_wait_for_node:
  * @self: a #QrtrBus.
@@ -237,6 +629,138 @@ QrtrNode *qrtr_bus_wait_for_node_finish (QrtrBus       *self,
                                          GAsyncResult  *res,
                                          GError       **error);
 
+/**
+ * qrtr_bus_wait_for_node_until:
+ * @self: a #QrtrBus.
+ * @node_id: the QRTR bus node ID to lookup.
+ * @deadline: the monotonic time, as given by g_get_monotonic_time(), at which
+ *  to stop waiting for the node to appear in the bus.
+ * @cancellable: a #GCancellable, or #NULL.
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Asynchronously waits until the node with the given @node_id is present in
+ * the bus, or until @deadline is reached.
+ *
+ * This is the same as qrtr_bus_wait_for_node(), but with an absolute deadline
+ * instead of a relative timeout, so that chained operations can share the
+ * same deadline. Operations with the same deadline share the same timer.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * qrtr_bus_wait_for_node_finish() to get the result of the operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_wait_for_node_until (QrtrBus             *self,
+                                   guint32              node_id,
+                                   gint64               deadline,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data);
+
+/**
+ * qrtr_bus_resolve_service:
+ * @self: a #QrtrBus.
+ * @node_id: the node ID where the service must be, or %QRTR_BUS_NODE_ID_ANY.
+ * @service: a service number.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ * @timeout_ms: the timeout, in milliseconds, to wait for the service to appear
+ *  in the bus.
+ * @cancellable: a #GCancellable, or #NULL.
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * Asynchronously waits for a server of the given service number, with a
+ * version in the [@min_version, @max_version] range and matching the given
+ * @instance, optionally in a specific node.
+ *
+ * This is equivalent to waiting for the node, then waiting for the service
+ * in the node and looking up its port, but with a single timeout for the
+ * whole operation. If a matching server is already known, the operation
+ * completes right away with the same server qrtr_bus_lookup_service() would
+ * return; otherwise it completes with the first matching server announced.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * qrtr_bus_resolve_service_finish() to get the result of the
+ * operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_resolve_service (QrtrBus             *self,
+                               guint32              node_id,
+                               guint32              service,
+                               guint32              min_version,
+                               guint32              max_version,
+                               guint32              instance,
+                               guint                timeout_ms,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data);
+
+/**
+ * qrtr_bus_resolve_service_until:
+ * @self: a #QrtrBus.
+ * @node_id: the node ID where the service must be, or %QRTR_BUS_NODE_ID_ANY.
+ * @service: a service number.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ * @deadline: the monotonic time, as given by g_get_monotonic_time(), at which
+ *  to stop waiting for the service to appear in the bus.
+ * @cancellable: a #GCancellable, or #NULL.
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * This is the same as qrtr_bus_resolve_service(), but with an absolute
+ * deadline instead of a relative timeout, so that chained operations can
+ * share the same deadline. Operations with the same deadline share the same
+ * timer.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * qrtr_bus_resolve_service_finish() to get the result of the operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_bus_resolve_service_until (QrtrBus             *self,
+                                     guint32              node_id,
+                                     guint32              service,
+                                     guint32              min_version,
+                                     guint32              max_version,
+                                     guint32              instance,
+                                     gint64               deadline,
+                                     GCancellable        *cancellable,
+                                     GAsyncReadyCallback  callback,
+                                     gpointer             user_data);
+
+/**
+ * qrtr_bus_resolve_service_finish:
+ * @self: a #QrtrBus.
+ * @res: a #GAsyncResult.
+ * @node_id: (out)(optional): return location for the node ID, or %NULL.
+ * @port: (out)(optional): return location for the port number, or %NULL.
+ * @client: (out)(optional)(transfer full): return location for a #QrtrClient
+ *  to communicate with the server, or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with qrtr_bus_resolve_service().
+ *
+ * If @client is given, a new #QrtrClient ready to communicate with the
+ * server is created, which should be freed with g_object_unref().
+ *
+ * Returns: %TRUE if the server was found and the requested outputs are set,
+ *  or %FALSE if @error is set.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_bus_resolve_service_finish (QrtrBus       *self,
+                                          GAsyncResult  *res,
+                                          guint32       *node_id,
+                                          guint32       *port,
+                                          QrtrClient   **client,
+                                          GError       **error);
+
 G_END_DECLS
 
 #endif /* _LIBQRTR_GLIB_QRTR_BUS_H_ */
@@ -19,6 +19,9 @@
 #include "qrtr-bus.h"
 #include "qrtr-node.h"
 #include "qrtr-client.h"
+#include "qrtr-loopback.h"
+#include "qrtr-reactor.h"
+#include "qrtr-utils.h"
 
 static void initable_iface_init (GInitableIface *iface);
 
@@ -29,11 +32,15 @@ enum {
     PROP_0,
     PROP_NODE,
     PROP_PORT,
+    PROP_DISPATCH_PRIORITY,
+    PROP_DISPATCH_BUDGET,
+    PROP_DISPATCH_THREADED,
     PROP_LAST
 };
 
 enum {
     SIGNAL_MESSAGE,
+    SIGNAL_MESSAGE_BYTES,
     SIGNAL_LAST
 };
 
@@ -43,14 +50,122 @@ static guint       signals   [SIGNAL_LAST] = { 0 };
 struct _QrtrClientPrivate {
     QrtrNode *node;
     guint     node_removed_id;
+    /* accessed atomically, messages may be sent from any thread */
     gboolean  removed;
     guint     port;
 
-    GSocket *socket;
-    GSource *source;
+    /* main context where the client was created */
+    GMainContext *context;
+
+    GSocket          *socket;
+    QrtrReactorWatch *watch;
     struct sockaddr_qrtr addr;
+
+    /* local address, as source of the messages handed over in memory */
+    guint32 local_node_id;
+    guint32 local_port;
+
+    /* dispatch scheduling */
+    gint     dispatch_priority;
+    guint    dispatch_budget;
+    gboolean dispatch_threaded;
+
+    /* threaded dispatch: messages pending to be emitted by a worker; the
+     * lock also protects the dispatch budget */
+    GMutex   strand_lock;
+    GQueue   strand_queue;
+    gboolean strand_scheduled;
+
+    /* slabs where messages are received into */
+    GPtrArray         *slabs;
+    struct _MessageSlab *slab;
 };
 
+/*****************************************************************************/
+/* Message slabs
+ *
+ * Messages are received into large refcounted buffers, and delivered as
+ * GBytes slices that keep a reference on the buffer, so that users can keep
+ * them beyond the signal handler (or pass them to other threads) without any
+ * copy. A slab is reused as soon as all the messages carved from it have been
+ * released.
+ */
+
+#define MESSAGE_SLAB_SIZE      (64 * 1024)
+#define MESSAGE_SLAB_MAX       4
+#define MESSAGE_SLAB_ALIGN(n)  (((n) + 7) & ~((gsize) 7))
+
+typedef struct _MessageSlab {
+    volatile gint  ref_count;
+    gsize          size;
+    gsize          offset;
+    guint8        *data;
+} MessageSlab;
+
+static MessageSlab *
+message_slab_new (gsize size)
+{
+    MessageSlab *slab;
+
+    slab = g_malloc (sizeof (MessageSlab) + size);
+    slab->ref_count = 1;
+    slab->size = size;
+    slab->offset = 0;
+    slab->data = (guint8 *)(slab + 1);
+    return slab;
+}
+
+static MessageSlab *
+message_slab_ref (MessageSlab *slab)
+{
+    g_atomic_int_inc (&slab->ref_count);
+    return slab;
+}
+
+static void
+message_slab_unref (MessageSlab *slab)
+{
+    if (g_atomic_int_dec_and_test (&slab->ref_count))
+        g_free (slab);
+}
+
+static MessageSlab *
+message_slab_reserve (QrtrClient *self,
+                      gsize       size)
+{
+    MessageSlab *slab;
+    guint        i;
+
+    /* big messages get their own buffer */
+    if (size > MESSAGE_SLAB_SIZE)
+        return NULL;
+
+    slab = self->priv->slab;
+    if (slab && slab->size - slab->offset >= size)
+        return slab;
+
+    /* Reuse any slab whose messages have all been released; the count can't
+     * grow behind our back because only we create new slices. */
+    for (i = 0; i < self->priv->slabs->len; i++) {
+        slab = g_ptr_array_index (self->priv->slabs, i);
+        if (g_atomic_int_get (&slab->ref_count) == 1) {
+            slab->offset = 0;
+            self->priv->slab = slab;
+            return slab;
+        }
+    }
+
+    /* If too many slabs are still in use, drop our reference on the oldest
+     * one, it will be freed when the user releases its messages. */
+    if (self->priv->slabs->len >= MESSAGE_SLAB_MAX)
+        g_ptr_array_remove_index (self->priv->slabs, 0);
+
+    slab = message_slab_new (MESSAGE_SLAB_SIZE);
+    g_ptr_array_add (self->priv->slabs, slab);
+    self->priv->slab = slab;
+    return slab;
+}
+
 /*****************************************************************************/
 
 static void
@@ -58,7 +173,7 @@ node_removed_cb (QrtrClient *self)
 {
     g_debug ("[qrtr client %u:%u] node removed from bus",
              qrtr_node_get_id (self->priv->node), self->priv->port);
-    self->priv->removed = TRUE;
+    g_atomic_int_set (&self->priv->removed, TRUE);
 }
 
 /*****************************************************************************/
@@ -97,12 +212,28 @@ qrtr_client_send (QrtrClient    *self,
 {
     gint fd;
 
-    if (self->priv->removed) {
+    if (g_atomic_int_get (&self->priv->removed)) {
         g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
                      "QRTR node was removed from the bus");
         return FALSE;
     }
 
+    /* the message is handed over in memory if the port is a server in this
+     * process */
+    switch (qrtr_loopback_send_data (self->priv->local_node_id, self->priv->local_port,
+                                     self->priv->addr.sq_node, self->priv->addr.sq_port,
+                                     message->data, message->len)) {
+    case QRTR_LOOPBACK_SEND_QUEUED:
+        return TRUE;
+    case QRTR_LOOPBACK_SEND_FULL:
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+                     "Failed to send QRTR message: loopback queue is full");
+        return FALSE;
+    case QRTR_LOOPBACK_SEND_NO_ENDPOINT:
+    default:
+        break;
+    }
+
     fd = g_socket_get_fd (self->priv->socket);
     if (sendto (fd, (void *)message->data, message->len,
                 0, (struct sockaddr *)&self->priv->addr, sizeof (self->priv->addr)) < 0) {
@@ -118,49 +249,427 @@ qrtr_client_send (QrtrClient    *self,
 
 /*****************************************************************************/
 
+gboolean
+qrtr_client_attach_filter (QrtrClient                *self,
+                           const struct sock_filter  *program,
+                           guint16                    n_instructions,
+                           GError                   **error)
+{
+    struct sock_fprog fprog;
+
+    g_return_val_if_fail (QRTR_IS_CLIENT (self), FALSE);
+    g_return_val_if_fail (program != NULL, FALSE);
+    g_return_val_if_fail (n_instructions > 0, FALSE);
+
+    fprog.len = n_instructions;
+    fprog.filter = (struct sock_filter *)program;
+
+    if (setsockopt (g_socket_get_fd (self->priv->socket), SOL_SOCKET, SO_ATTACH_FILTER,
+                    &fprog, sizeof (fprog)) < 0) {
+        g_set_error (error,
+                     G_IO_ERROR,
+                     g_io_error_from_errno (errno),
+                     "Failed to attach socket filter: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+gboolean
+qrtr_client_detach_filter (QrtrClient  *self,
+                           GError     **error)
+{
+    gint unused = 0;
+
+    g_return_val_if_fail (QRTR_IS_CLIENT (self), FALSE);
+
+    if (setsockopt (g_socket_get_fd (self->priv->socket), SOL_SOCKET, SO_DETACH_FILTER,
+                    &unused, sizeof (unused)) < 0) {
+        g_set_error (error,
+                     G_IO_ERROR,
+                     g_io_error_from_errno (errno),
+                     "Failed to detach socket filter: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Non-zero return values accept the message, truncated to that length */
+#define FILTER_ACCEPT 0xffffffff
+#define FILTER_DROP   0
+
+static void
+filter_append (GArray   *program,
+               guint16   code,
+               guint8    jt,
+               guint8    jf,
+               guint32   k)
+{
+    struct sock_filter insn;
+
+    insn.code = code;
+    insn.jt = jt;
+    insn.jf = jf;
+    insn.k = k;
+    g_array_append_val (program, insn);
+}
+
+static void
+filter_append_load (GArray                *program,
+                    guint                  offset,
+                    QrtrClientFilterField  field)
+{
+    guint n_bytes;
+    guint i;
+
+    switch (field) {
+    case QRTR_CLIENT_FILTER_FIELD_UINT8:
+        filter_append (program, BPF_LD | BPF_B | BPF_ABS, 0, 0, offset);
+        return;
+    case QRTR_CLIENT_FILTER_FIELD_UINT16_BE:
+        filter_append (program, BPF_LD | BPF_H | BPF_ABS, 0, 0, offset);
+        return;
+    case QRTR_CLIENT_FILTER_FIELD_UINT32_BE:
+        filter_append (program, BPF_LD | BPF_W | BPF_ABS, 0, 0, offset);
+        return;
+    case QRTR_CLIENT_FILTER_FIELD_UINT16_LE:
+        n_bytes = 2;
+        break;
+    case QRTR_CLIENT_FILTER_FIELD_UINT32_LE:
+        n_bytes = 4;
+        break;
+    default:
+        g_assert_not_reached ();
+    }
+
+    /* Absolute loads are always in network byte order, so little endian
+     * fields are built byte by byte, using the scratch memory to accumulate
+     * the value: A = byte[offset + i] << (8 * i) | M[0] */
+    for (i = n_bytes; i > 0; i--) {
+        filter_append (program, BPF_LD | BPF_B | BPF_ABS, 0, 0, offset + i - 1);
+        if (i > 1)
+            filter_append (program, BPF_ALU | BPF_LSH | BPF_K, 0, 0, 8 * (i - 1));
+        if (i < n_bytes) {
+            filter_append (program, BPF_LDX | BPF_MEM, 0, 0, 0);
+            filter_append (program, BPF_ALU | BPF_OR | BPF_X, 0, 0, 0);
+        }
+        if (i > 1)
+            filter_append (program, BPF_ST, 0, 0, 0);
+    }
+}
+
+gboolean
+qrtr_client_set_message_filter (QrtrClient                   *self,
+                                guint                         offset,
+                                QrtrClientFilterField         field,
+                                gboolean                      allow,
+                                const QrtrClientFilterRange  *ranges,
+                                guint                         n_ranges,
+                                GError                      **error)
+{
+    g_autoptr(GArray) program = NULL;
+    guint             i;
+
+    g_return_val_if_fail (QRTR_IS_CLIENT (self), FALSE);
+    g_return_val_if_fail (ranges != NULL || n_ranges == 0, FALSE);
+
+    /* conditional jumps are limited to 255 instructions */
+    if (n_ranges > QRTR_CLIENT_FILTER_MAX_RANGES) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     "Too many filter ranges: %u (maximum %u)",
+                     n_ranges, QRTR_CLIENT_FILTER_MAX_RANGES);
+        return FALSE;
+    }
+
+    for (i = 0; i < n_ranges; i++) {
+        if (ranges[i].min > ranges[i].max) {
+            g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                         "Invalid filter range: [%u, %u]", ranges[i].min, ranges[i].max);
+            return FALSE;
+        }
+    }
+
+    program = g_array_new (FALSE, FALSE, sizeof (struct sock_filter));
+
+    filter_append_load (program, offset, field);
+
+    /* Two instructions per range:
+     *   if (A < min) goto next range
+     *   if (A > max) goto next range, else goto match
+     */
+    for (i = 0; i < n_ranges; i++) {
+        filter_append (program, BPF_JMP | BPF_JGE | BPF_K, 0, 1, ranges[i].min);
+        filter_append (program, BPF_JMP | BPF_JGT | BPF_K, 0, 2 * (n_ranges - i) - 1, ranges[i].max);
+    }
+
+    /* no match */
+    filter_append (program, BPF_RET | BPF_K, 0, 0, allow ? FILTER_DROP : FILTER_ACCEPT);
+    /* match */
+    filter_append (program, BPF_RET | BPF_K, 0, 0, allow ? FILTER_ACCEPT : FILTER_DROP);
+
+    g_debug ("[qrtr client %u:%u] %s filter compiled: %u ranges, %u instructions",
+             qrtr_node_get_id (self->priv->node), self->priv->port,
+             allow ? "allow" : "deny", n_ranges, program->len);
+
+    return qrtr_client_attach_filter (self,
+                                      (const struct sock_filter *)program->data,
+                                      (guint16) program->len,
+                                      error);
+}
+
+/*****************************************************************************/
+
+static void
+emit_message_bytes (QrtrClient *self,
+                    GBytes     *bytes)
+{
+    gsize size;
+
+    g_signal_emit (self, signals[SIGNAL_MESSAGE_BYTES], 0, bytes);
+
+    /* users of the legacy signal get their own modifiable copy */
+    if (g_signal_has_handler_pending (self, signals[SIGNAL_MESSAGE], 0, FALSE)) {
+        g_autoptr(GByteArray) buf = NULL;
+        gconstpointer         data;
+
+        data = g_bytes_get_data (bytes, &size);
+        buf = g_byte_array_sized_new (size);
+        g_byte_array_append (buf, data, size);
+        g_signal_emit (self, signals[SIGNAL_MESSAGE], 0, buf);
+    }
+}
+
+/*****************************************************************************/
+/* Threaded dispatch
+ *
+ * Clients created with threaded dispatch still receive their messages in
+ * the main context, but the signals are emitted from a process-wide pool of
+ * worker threads. Each client is a strand: it is scheduled in the pool at
+ * most once at a time, so its messages are always emitted in order, while
+ * the messages of different clients are emitted concurrently.
+ */
+
+static void strand_run (QrtrClient *self,
+                        gpointer    unused);
+
+static guint
+dispatch_budget_get (QrtrClient *self)
+{
+    guint budget;
+
+    g_mutex_lock (&self->priv->strand_lock);
+    budget = self->priv->dispatch_budget;
+    g_mutex_unlock (&self->priv->strand_lock);
+    return budget;
+}
+
+static GThreadPool *
+strand_pool_get (void)
+{
+    static gsize pool = 0;
+
+    if (g_once_init_enter (&pool)) {
+        GThreadPool *new_pool;
+
+        new_pool = g_thread_pool_new ((GFunc) strand_run,
+                                      NULL,
+                                      (gint) g_get_num_processors (),
+                                      FALSE,
+                                      NULL);
+        g_assert (new_pool);
+        g_once_init_leave (&pool, (gsize) new_pool);
+    }
+    return (GThreadPool *) pool;
+}
+
+void
+qrtr_client_set_dispatch_threads (guint n_threads)
+{
+    if (!n_threads)
+        n_threads = g_get_num_processors ();
+    g_thread_pool_set_max_threads (strand_pool_get (), (gint) MIN (n_threads, G_MAXINT), NULL);
+}
+
+static gboolean
+strand_release_cb (QrtrClient *self)
+{
+    g_object_unref (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+strand_release (QrtrClient *self)
+{
+    GSource *source;
+
+    /* The reference taken when scheduled may be the last one, and the client
+     * must be disposed in its own main context, where its sources live. An
+     * idle source instead of g_main_context_invoke(), which would run the
+     * callback right here if the context isn't owned by any thread. */
+    source = g_idle_source_new ();
+    g_source_set_callback (source, (GSourceFunc) strand_release_cb, self, NULL);
+    g_source_attach (source, self->priv->context);
+    g_source_unref (source);
+}
+
+static void
+strand_run (QrtrClient *self,
+            gpointer    unused)
+{
+    guint n_messages;
+    guint budget;
+
+    budget = dispatch_budget_get (self);
+
+    /* Emit at most the dispatch budget of messages, then go back to the end
+     * of the pool queue so that other clients get their share. */
+    for (n_messages = 0; n_messages < budget; n_messages++) {
+        GBytes *bytes;
+
+        g_mutex_lock (&self->priv->strand_lock);
+        bytes = g_queue_pop_head (&self->priv->strand_queue);
+        if (!bytes) {
+            self->priv->strand_scheduled = FALSE;
+            g_mutex_unlock (&self->priv->strand_lock);
+            strand_release (self);
+            return;
+        }
+        g_mutex_unlock (&self->priv->strand_lock);
+
+        emit_message_bytes (self, bytes);
+        g_bytes_unref (bytes);
+    }
+
+    /* still scheduled, the reference goes along */
+    g_thread_pool_push (strand_pool_get (), self, NULL);
+}
+
+static void
+strand_push (QrtrClient *self,
+             GBytes     *bytes)
+{
+    gboolean schedule;
+
+    g_mutex_lock (&self->priv->strand_lock);
+    g_queue_push_tail (&self->priv->strand_queue, bytes);
+    schedule = !self->priv->strand_scheduled;
+    self->priv->strand_scheduled = TRUE;
+    g_mutex_unlock (&self->priv->strand_lock);
+
+    if (schedule)
+        g_thread_pool_push (strand_pool_get (), g_object_ref (self), NULL);
+}
+
+/*****************************************************************************/
+
 static gboolean
-qrtr_message_cb (GSocket      *gsocket,
-                 GIOCondition  cond,
-                 QrtrClient   *self)
+receive_message (QrtrClient *self,
+                 GSocket    *gsocket)
 {
-    g_autoptr(GError)         error = NULL;
-    g_autoptr(GSocketAddress) addr = NULL;
-    struct sockaddr_qrtr      sq;
-    g_autoptr(GByteArray)     buf = NULL;
-    gssize                    next_datagram_size;
-    gssize                    bytes_received;
+    g_autoptr(GBytes)     bytes = NULL;
+    MessageSlab          *slab = NULL;
+    guint8               *data;
+    struct sockaddr_qrtr  sq;
+    socklen_t             sq_len;
+    gboolean              want_bytes;
+    gssize                next_datagram_size;
+    gssize                bytes_received;
 
     next_datagram_size = g_socket_get_available_bytes (gsocket);
-    buf = g_byte_array_sized_new (next_datagram_size);
-    g_byte_array_set_size (buf, next_datagram_size);
+    if (next_datagram_size < 0) {
+        g_warning ("[qrtr client %u:%u] socket i/o failure: couldn't get message size",
+                   qrtr_node_get_id (self->priv->node), self->priv->port);
+        return FALSE;
+    }
 
-    bytes_received = g_socket_receive_from (gsocket, &addr, (gchar *)buf->data,
-                                            next_datagram_size, NULL, &error);
+    /* slab slices only make sense if someone is going to get them, or if
+     * the message needs to be queued for a worker thread */
+    want_bytes = (self->priv->dispatch_threaded ||
+                  g_signal_has_handler_pending (self, signals[SIGNAL_MESSAGE_BYTES], 0, FALSE));
+    if (want_bytes)
+        slab = message_slab_reserve (self, next_datagram_size);
+    data = slab ? (slab->data + slab->offset) : g_malloc (next_datagram_size);
+
+    sq_len = sizeof (sq);
+    bytes_received = recvfrom (g_socket_get_fd (gsocket), data, next_datagram_size,
+                               MSG_DONTWAIT, (struct sockaddr *)&sq, &sq_len);
     if (bytes_received < 0) {
+        gint saved_errno = errno;
+
+        if (!slab)
+            g_free (data);
+        if (saved_errno == EAGAIN || saved_errno == EWOULDBLOCK || saved_errno == EINTR)
+            return TRUE;
         g_warning ("[qrtr client %u:%u] socket i/o failure: %s",
-                   qrtr_node_get_id (self->priv->node), self->priv->port, error->message);
+                   qrtr_node_get_id (self->priv->node), self->priv->port, g_strerror (saved_errno));
         return FALSE;
     }
 
     if (bytes_received != next_datagram_size) {
         g_warning ("[qrtr client %u:%u] unexpected message size",
                    qrtr_node_get_id (self->priv->node), self->priv->port);
+        if (!slab)
+            g_free (data);
         return TRUE;
     }
 
-    if (!g_socket_address_to_native (addr, &sq, sizeof (sq), &error)) {
-        g_warning ("[qrtr client %u:%u] could not parse QRTR address: %s",
-                   qrtr_node_get_id (self->priv->node), self->priv->port, error->message);
+    if (sq_len < sizeof (sq) ||
+        sq.sq_family != AF_QIPCRTR ||
+        sq.sq_node != qrtr_node_get_id (self->priv->node) ||
+        sq.sq_port != self->priv->port) {
+        if (!slab)
+            g_free (data);
         return TRUE;
     }
 
-    if (sq.sq_family != AF_QIPCRTR ||
-        sq.sq_node != qrtr_node_get_id (self->priv->node) ||
-        sq.sq_port != self->priv->port) {
+    if (!want_bytes) {
+        g_autoptr(GByteArray) buf = NULL;
+
+        buf = g_byte_array_new_take (data, bytes_received);
+        g_signal_emit (self, signals[SIGNAL_MESSAGE], 0, buf);
         return TRUE;
     }
 
-    g_signal_emit (self, signals[SIGNAL_MESSAGE], 0, buf);
+    if (slab) {
+        slab->offset = MIN (slab->offset + MESSAGE_SLAB_ALIGN ((gsize) bytes_received), slab->size);
+        bytes = g_bytes_new_with_free_func (data, bytes_received,
+                                            (GDestroyNotify) message_slab_unref,
+                                            message_slab_ref (slab));
+    } else
+        bytes = g_bytes_new_take (data, bytes_received);
+
+    if (self->priv->dispatch_threaded)
+        strand_push (self, g_steal_pointer (&bytes));
+    else
+        emit_message_bytes (self, bytes);
+
+    return TRUE;
+}
+
+static gboolean
+qrtr_message_cb (QrtrClient *self)
+{
+    g_autoptr(QrtrClient) keep_alive = NULL;
+    guint                 n_messages;
+    guint                 budget;
+
+    /* Each client dispatches at most its budget of messages per main loop
+     * iteration, so that all clients with the same priority get a share of
+     * the dispatching proportional to their budget, regardless of how chatty
+     * the others are. */
+    keep_alive = g_object_ref (self);
+    budget = dispatch_budget_get (self);
+    for (n_messages = 0; n_messages < budget; n_messages++) {
+        /* the client may have been disposed by the message handler */
+        if (!self->priv->watch)
+            break;
+        if (n_messages > 0 && !(g_socket_condition_check (self->priv->socket, G_IO_IN) & G_IO_IN))
+            break;
+        if (!receive_message (self, self->priv->socket))
+            return FALSE;
+    }
 
     return TRUE;
 }
@@ -181,6 +690,8 @@ initable_init (GInitable    *initable,
         return FALSE;
     }
 
+    self->priv->context = g_main_context_ref_thread_default ();
+
     self->priv->addr.sq_family = AF_QIPCRTR;
     self->priv->addr.sq_node = qrtr_node_get_id (self->priv->node);
     self->priv->addr.sq_port = (guint) self->priv->port;
@@ -201,11 +712,19 @@ initable_init (GInitable    *initable,
 
     g_socket_set_timeout (self->priv->socket, 0);
 
-    self->priv->source = g_socket_create_source (self->priv->socket, G_IO_IN, NULL);
-    g_source_set_callback (self->priv->source, (GSourceFunc) qrtr_message_cb, self, NULL);
-    g_source_attach (self->priv->source, g_main_context_get_thread_default ());
+    /* bind right away instead of on the first message sent, so that the
+     * address is known by the servers in this same process which get our
+     * messages in memory, and their replies reach us through the socket */
+    if (!qrtr_socket_bind_local (fd, &self->priv->local_node_id, &self->priv->local_port, error))
+        return FALSE;
 
-    return TRUE;
+    self->priv->watch = qrtr_reactor_watch_add (g_main_context_get_thread_default (),
+                                                fd,
+                                                self->priv->dispatch_priority,
+                                                (QrtrReactorFunc) qrtr_message_cb,
+                                                self,
+                                                error);
+    return !!self->priv->watch;
 }
 
 /*****************************************************************************/
@@ -233,6 +752,10 @@ qrtr_client_init (QrtrClient *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               QRTR_TYPE_CLIENT,
                                               QrtrClientPrivate);
+
+    self->priv->slabs = g_ptr_array_new_with_free_func ((GDestroyNotify) message_slab_unref);
+    g_mutex_init (&self->priv->strand_lock);
+    g_queue_init (&self->priv->strand_queue);
 }
 
 static void
@@ -255,6 +778,23 @@ set_property (GObject      *object,
     case PROP_PORT:
         self->priv->port = (guint32) g_value_get_uint (value);
         break;
+    case PROP_DISPATCH_PRIORITY:
+        self->priv->dispatch_priority = g_value_get_int (value);
+        if (self->priv->watch) {
+            g_autoptr(GError) error = NULL;
+
+            if (!qrtr_reactor_watch_set_priority (self->priv->watch, self->priv->dispatch_priority, &error))
+                g_warning ("[qrtr client] couldn't update dispatch priority: %s", error->message);
+        }
+        break;
+    case PROP_DISPATCH_BUDGET:
+        g_mutex_lock (&self->priv->strand_lock);
+        self->priv->dispatch_budget = g_value_get_uint (value);
+        g_mutex_unlock (&self->priv->strand_lock);
+        break;
+    case PROP_DISPATCH_THREADED:
+        self->priv->dispatch_threaded = g_value_get_boolean (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -276,6 +816,15 @@ get_property (GObject    *object,
     case PROP_PORT:
         g_value_set_uint (value, (guint) self->priv->port);
         break;
+    case PROP_DISPATCH_PRIORITY:
+        g_value_set_int (value, self->priv->dispatch_priority);
+        break;
+    case PROP_DISPATCH_BUDGET:
+        g_value_set_uint (value, dispatch_budget_get (self));
+        break;
+    case PROP_DISPATCH_THREADED:
+        g_value_set_boolean (value, self->priv->dispatch_threaded);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -287,10 +836,7 @@ dispose (GObject *object)
 {
     QrtrClient *self = QRTR_CLIENT (object);
 
-    if (self->priv->source) {
-        g_source_destroy (self->priv->source);
-        g_clear_pointer (&self->priv->source, g_source_unref);
-    }
+    g_clear_pointer (&self->priv->watch, qrtr_reactor_watch_remove);
     if (self->priv->socket) {
         if (!g_socket_is_closed (self->priv->socket))
             g_socket_close (self->priv->socket, NULL);
@@ -302,9 +848,30 @@ dispose (GObject *object)
     }
     g_clear_object (&self->priv->node);
 
+    /* slabs still referenced by messages are freed when these are released */
+    self->priv->slab = NULL;
+    g_clear_pointer (&self->priv->slabs, g_ptr_array_unref);
+
     G_OBJECT_CLASS (qrtr_client_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    QrtrClient *self = QRTR_CLIENT (object);
+    GBytes     *bytes;
+
+    /* a scheduled strand holds a reference, so the queue is empty unless the
+     * object was explicitly disposed */
+    while ((bytes = g_queue_pop_head (&self->priv->strand_queue)) != NULL)
+        g_bytes_unref (bytes);
+    g_mutex_clear (&self->priv->strand_lock);
+    if (self->priv->context)
+        g_main_context_unref (self->priv->context);
+
+    G_OBJECT_CLASS (qrtr_client_parent_class)->finalize (object);
+}
+
 static void
 initable_iface_init (GInitableIface *iface)
 {
@@ -321,6 +888,7 @@ qrtr_client_class_init (QrtrClientClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose      = dispose;
+    object_class->finalize     = finalize;
 
     /**
      * QrtrClient:client-node:
@@ -350,6 +918,69 @@ qrtr_client_class_init (QrtrClientClass *klass)
                            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
     g_object_class_install_property (object_class, PROP_PORT, properties[PROP_PORT]);
 
+    /**
+     * QrtrClient:client-dispatch-priority:
+     *
+     * The priority of the main context source dispatching the messages of
+     * the client. As with any other source, clients with a higher priority
+     * (i.e. a lower value) are always dispatched before the ones with a lower
+     * priority, so this allows defining priority classes, e.g. to avoid
+     * latency-sensitive control clients being delayed by bulk data clients.
+     *
+     * Since: 1.4
+     */
+    properties[PROP_DISPATCH_PRIORITY] =
+        g_param_spec_int (QRTR_CLIENT_DISPATCH_PRIORITY,
+                          "dispatch priority",
+                          "Priority of the source dispatching the messages",
+                          G_MININT,
+                          G_MAXINT,
+                          G_PRIORITY_DEFAULT,
+                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+    g_object_class_install_property (object_class, PROP_DISPATCH_PRIORITY, properties[PROP_DISPATCH_PRIORITY]);
+
+    /**
+     * QrtrClient:client-dispatch-budget:
+     *
+     * The maximum number of messages of the client dispatched in a single
+     * main loop iteration. Clients with the same dispatch priority get a share
+     * of the dispatching proportional to their budget.
+     *
+     * Since: 1.4
+     */
+    properties[PROP_DISPATCH_BUDGET] =
+        g_param_spec_uint (QRTR_CLIENT_DISPATCH_BUDGET,
+                           "dispatch budget",
+                           "Maximum number of messages dispatched per main loop iteration",
+                           1,
+                           G_MAXUINT,
+                           1,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+    g_object_class_install_property (object_class, PROP_DISPATCH_BUDGET, properties[PROP_DISPATCH_BUDGET]);
+
+    /**
+     * QrtrClient:client-dispatch-threaded:
+     *
+     * Whether the message signals of the client are emitted from a worker
+     * thread instead of from the main context.
+     *
+     * Messages are still received in the main context, and then handed to a
+     * process-wide pool of worker threads (as many as processors available)
+     * shared by all the clients using threaded dispatch. The messages of a
+     * given client are always emitted in order and never concurrently, but
+     * the handlers of different clients may run in parallel, so they must be
+     * thread-safe.
+     *
+     * Since: 1.4
+     */
+    properties[PROP_DISPATCH_THREADED] =
+        g_param_spec_boolean (QRTR_CLIENT_DISPATCH_THREADED,
+                              "dispatch threaded",
+                              "Whether messages are dispatched in a worker thread",
+                              FALSE,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_DISPATCH_THREADED, properties[PROP_DISPATCH_THREADED]);
+
     /**
      * QrtrClient::client-message
      * @self: the #QrtrClient
@@ -376,4 +1007,32 @@ qrtr_client_class_init (QrtrClientClass *klass)
                       G_TYPE_NONE,
                       1,
                       G_TYPE_BYTE_ARRAY);
+
+    /**
+     * QrtrClient::client-message-bytes
+     * @self: the #QrtrClient
+     * @message: the message data.
+     *
+     * The ::client-message-bytes signal is emitted when a message is received
+     * from the port in the node.
+     *
+     * The @message is an immutable slice of a buffer shared with other
+     * messages, so it can be kept after the signal handler returns (e.g.
+     * queued, or passed to another thread) with g_bytes_ref(), without any
+     * copy. The shared buffer is reused once all the messages in it are
+     * released, so users should not keep them for longer than needed.
+     *
+     * Since: 1.4
+     */
+    signals[SIGNAL_MESSAGE_BYTES] =
+        g_signal_new (QRTR_CLIENT_SIGNAL_MESSAGE_BYTES,
+                      G_OBJECT_CLASS_TYPE (G_OBJECT_CLASS (klass)),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL,
+                      NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      1,
+                      G_TYPE_BYTES);
 }
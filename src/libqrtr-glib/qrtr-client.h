@@ -14,6 +14,7 @@
 #endif
 
 #include <glib-object.h>
+#include <linux/filter.h>
 
 #include "qrtr-types.h"
 
@@ -56,6 +57,34 @@ typedef struct _QrtrClientPrivate QrtrClientPrivate;
  */
 #define QRTR_CLIENT_PORT "client-port"
 
+/**
+ * QRTR_CLIENT_DISPATCH_PRIORITY:
+ *
+ * The priority of the source dispatching the messages of this client.
+ *
+ * Since: 1.4
+ */
+#define QRTR_CLIENT_DISPATCH_PRIORITY "client-dispatch-priority"
+
+/**
+ * QRTR_CLIENT_DISPATCH_BUDGET:
+ *
+ * The maximum number of messages of this client dispatched in a single main
+ * loop iteration.
+ *
+ * Since: 1.4
+ */
+#define QRTR_CLIENT_DISPATCH_BUDGET "client-dispatch-budget"
+
+/**
+ * QRTR_CLIENT_DISPATCH_THREADED:
+ *
+ * Whether the messages of this client are dispatched in a worker thread.
+ *
+ * Since: 1.4
+ */
+#define QRTR_CLIENT_DISPATCH_THREADED "client-dispatch-threaded"
+
 /**
  * QRTR_CLIENT_SIGNAL_MESSAGE:
  *
@@ -65,6 +94,15 @@ typedef struct _QrtrClientPrivate QrtrClientPrivate;
  */
 #define QRTR_CLIENT_SIGNAL_MESSAGE "client-message"
 
+/**
+ * QRTR_CLIENT_SIGNAL_MESSAGE_BYTES:
+ *
+ * Symbol defining the #QrtrClient::client-message-bytes signal.
+ *
+ * Since: 1.4
+ */
+#define QRTR_CLIENT_SIGNAL_MESSAGE_BYTES "client-message-bytes"
+
 /**
  * QrtrClient:
  *
@@ -163,6 +201,130 @@ gboolean qrtr_client_send (QrtrClient    *self,
                            GCancellable  *cancellable,
                            GError       **error);
 
+/**
+ * qrtr_client_attach_filter: (skip)
+ * @self: a #QrtrClient.
+ * @program: an array of classic BPF instructions.
+ * @n_instructions: the number of instructions in @program.
+ * @error: Return location for #GError or %NULL.
+ *
+ * Attaches a classic BPF socket filter to the client socket, replacing any
+ * previous one.
+ *
+ * The filter runs in the kernel over the message payload, before the message
+ * is queued in the socket, so the messages it discards never wake up the
+ * process nor get copied to userspace.
+ *
+ * Returns: %TRUE if the filter is attached, or %FALSE if @error is set.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_client_attach_filter (QrtrClient                *self,
+                                    const struct sock_filter  *program,
+                                    guint16                    n_instructions,
+                                    GError                   **error);
+
+/**
+ * qrtr_client_detach_filter:
+ * @self: a #QrtrClient.
+ * @error: Return location for #GError or %NULL.
+ *
+ * Detaches the socket filter previously attached with
+ * qrtr_client_attach_filter() or qrtr_client_set_message_filter().
+ *
+ * Returns: %TRUE if the filter is detached, or %FALSE if @error is set.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_client_detach_filter (QrtrClient  *self,
+                                    GError     **error);
+
+/**
+ * QrtrClientFilterField:
+ * @QRTR_CLIENT_FILTER_FIELD_UINT8: 8-bit field.
+ * @QRTR_CLIENT_FILTER_FIELD_UINT16_LE: 16-bit field, in little endian.
+ * @QRTR_CLIENT_FILTER_FIELD_UINT16_BE: 16-bit field, in big endian.
+ * @QRTR_CLIENT_FILTER_FIELD_UINT32_LE: 32-bit field, in little endian.
+ * @QRTR_CLIENT_FILTER_FIELD_UINT32_BE: 32-bit field, in big endian.
+ *
+ * Type of the message field evaluated by qrtr_client_set_message_filter().
+ *
+ * Since: 1.4
+ */
+typedef enum {
+    QRTR_CLIENT_FILTER_FIELD_UINT8,
+    QRTR_CLIENT_FILTER_FIELD_UINT16_LE,
+    QRTR_CLIENT_FILTER_FIELD_UINT16_BE,
+    QRTR_CLIENT_FILTER_FIELD_UINT32_LE,
+    QRTR_CLIENT_FILTER_FIELD_UINT32_BE
+} QrtrClientFilterField;
+
+/**
+ * QrtrClientFilterRange:
+ * @min: the minimum value of the range, inclusive.
+ * @max: the maximum value of the range, inclusive.
+ *
+ * A range of field values evaluated by qrtr_client_set_message_filter().
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    guint32 min;
+    guint32 max;
+} QrtrClientFilterRange;
+
+/**
+ * QRTR_CLIENT_FILTER_MAX_RANGES:
+ *
+ * Maximum number of ranges supported by qrtr_client_set_message_filter().
+ *
+ * Since: 1.4
+ */
+#define QRTR_CLIENT_FILTER_MAX_RANGES 64
+
+/**
+ * qrtr_client_set_message_filter:
+ * @self: a #QrtrClient.
+ * @offset: offset of the field in the message, in bytes.
+ * @field: a #QrtrClientFilterField specifying the field size and endianness.
+ * @allow: %TRUE if the @ranges list the messages to receive, %FALSE if they
+ *  list the messages to discard.
+ * @ranges: (array length=n_ranges): an array of #QrtrClientFilterRange.
+ * @n_ranges: the number of elements in @ranges.
+ * @error: Return location for #GError or %NULL.
+ *
+ * Compiles a socket filter that evaluates the value of the field at @offset
+ * in every message (e.g. the QMI message id), and accepts or discards the
+ * message depending on whether the value is included in any of the @ranges.
+ * The filter is then attached with qrtr_client_attach_filter().
+ *
+ * Messages too short to contain the field are always discarded.
+ *
+ * Returns: %TRUE if the filter is attached, or %FALSE if @error is set.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_client_set_message_filter (QrtrClient                   *self,
+                                         guint                         offset,
+                                         QrtrClientFilterField         field,
+                                         gboolean                      allow,
+                                         const QrtrClientFilterRange  *ranges,
+                                         guint                         n_ranges,
+                                         GError                      **error);
+
+/**
+ * qrtr_client_set_dispatch_threads:
+ * @n_threads: the maximum number of worker threads, or 0 for the number of
+ *  processors.
+ *
+ * Sets the maximum number of worker threads emitting the messages of the
+ * clients with %QRTR_CLIENT_DISPATCH_THREADED, shared by all of them in the
+ * process. By default there are as many as processors.
+ *
+ * Since: 1.4
+ */
+void qrtr_client_set_dispatch_threads (guint n_threads);
+
 G_END_DECLS
 
 #endif /* _LIBQRTR_GLIB_QRTR_CLIENT_H_ */
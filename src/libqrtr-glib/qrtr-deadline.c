@@ -0,0 +1,168 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <glib.h>
+
+#include "qrtr-deadline.h"
+
+typedef struct {
+    GMainContext *context;
+    gint64        deadline;
+} DeadlineKey;
+
+typedef struct {
+    GSource     source;
+    DeadlineKey key;
+    /* QrtrDeadlineTimers not fired yet */
+    GQueue      timers;
+    gboolean    dispatching;
+} DeadlineSource;
+
+struct _QrtrDeadlineTimer {
+    /* NULL once fired */
+    DeadlineSource *source;
+    GList           link;
+    GSourceFunc     callback;
+    gpointer        user_data;
+};
+
+/* (context, deadline) -> DeadlineSource */
+G_LOCK_DEFINE_STATIC (sources);
+static GHashTable *sources;
+
+static guint
+deadline_key_hash (const DeadlineKey *key)
+{
+    return g_direct_hash (key->context) ^ g_int64_hash (&key->deadline);
+}
+
+static gboolean
+deadline_key_equal (const DeadlineKey *a,
+                    const DeadlineKey *b)
+{
+    return a->context == b->context && a->deadline == b->deadline;
+}
+
+static void
+deadline_source_unregister (DeadlineSource *self)
+{
+    G_LOCK (sources);
+    if (g_hash_table_lookup (sources, &self->key) == self)
+        g_hash_table_remove (sources, &self->key);
+    G_UNLOCK (sources);
+}
+
+/*****************************************************************************/
+
+gint64
+qrtr_deadline_from_timeout (guint timeout_ms)
+{
+    gint64 deadline;
+
+    /* rounded up to whole milliseconds, so that timeouts given at about
+     * the same time share the timer */
+    deadline = g_get_monotonic_time () + (gint64) timeout_ms * 1000;
+    return ((deadline + 999) / 1000) * 1000;
+}
+
+/*****************************************************************************/
+
+static gboolean
+deadline_source_dispatch (GSource     *source,
+                          GSourceFunc  callback,
+                          gpointer     user_data)
+{
+    DeadlineSource *self = (DeadlineSource *) source;
+
+    /* no new timers may be added to a source being dispatched */
+    deadline_source_unregister (self);
+    self->dispatching = TRUE;
+
+    /* the callbacks may remove other timers of this same source */
+    while (!g_queue_is_empty (&self->timers)) {
+        QrtrDeadlineTimer *timer;
+
+        timer = g_queue_peek_head (&self->timers);
+        g_queue_unlink (&self->timers, &timer->link);
+        timer->source = NULL;
+        timer->callback (timer->user_data);
+    }
+
+    /* drop the reference owned by the registry; the main context keeps its
+     * own one until we return */
+    g_source_unref (source);
+    return G_SOURCE_REMOVE;
+}
+
+static GSourceFuncs deadline_source_funcs = {
+    NULL, /* prepare */
+    NULL, /* check */
+    deadline_source_dispatch,
+    NULL, /* finalize */
+    NULL, /* closure_callback */
+    NULL, /* closure_marshal */
+};
+
+QrtrDeadlineTimer *
+qrtr_deadline_timer_add (GMainContext *context,
+                         gint64        deadline,
+                         GSourceFunc   callback,
+                         gpointer      user_data)
+{
+    QrtrDeadlineTimer *timer;
+    DeadlineSource    *source;
+    DeadlineKey        key;
+
+    key.context = context ? context : g_main_context_default ();
+    key.deadline = deadline;
+
+    G_LOCK (sources);
+    if (!sources)
+        sources = g_hash_table_new ((GHashFunc) deadline_key_hash, (GEqualFunc) deadline_key_equal);
+    source = g_hash_table_lookup (sources, &key);
+    if (!source) {
+        source = (DeadlineSource *) g_source_new (&deadline_source_funcs, sizeof (DeadlineSource));
+        source->key = key;
+        g_queue_init (&source->timers);
+        g_source_set_name ((GSource *) source, "qrtr deadline");
+        g_source_set_ready_time ((GSource *) source, deadline);
+        g_source_attach ((GSource *) source, key.context);
+        /* the registry owns the source reference */
+        g_hash_table_insert (sources, &source->key, source);
+    }
+    G_UNLOCK (sources);
+
+    timer = g_slice_new0 (QrtrDeadlineTimer);
+    timer->source = source;
+    timer->link.data = timer;
+    timer->callback = callback;
+    timer->user_data = user_data;
+    g_queue_push_tail_link (&source->timers, &timer->link);
+
+    return timer;
+}
+
+void
+qrtr_deadline_timer_remove (QrtrDeadlineTimer *timer)
+{
+    DeadlineSource *source;
+
+    source = timer->source;
+    if (source) {
+        g_queue_unlink (&source->timers, &timer->link);
+        /* the last timer takes the source with it, unless it's being
+         * dispatched */
+        if (g_queue_is_empty (&source->timers) && !source->dispatching) {
+            deadline_source_unregister (source);
+            g_source_destroy ((GSource *) source);
+            g_source_unref ((GSource *) source);
+        }
+    }
+
+    g_slice_free (QrtrDeadlineTimer, timer);
+}
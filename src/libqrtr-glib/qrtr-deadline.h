@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_DEADLINE_H_
+#define _LIBQRTR_GLIB_QRTR_DEADLINE_H_
+
+#if !defined (LIBQRTR_GLIB_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <glib.h>
+
+/*
+ * Deadline timers fire once the monotonic clock reaches the given deadline.
+ * All the timers with the same deadline in the same main context share a
+ * single GSource, so that operations chained under a common deadline don't
+ * each add their own source to the main context.
+ *
+ * Timers are one-shot: once fired they are no longer scheduled, but they
+ * must still be removed by their owner, either before or after firing.
+ * Timers must be added and removed from the thread running the context.
+ */
+
+typedef struct _QrtrDeadlineTimer QrtrDeadlineTimer;
+
+G_GNUC_INTERNAL
+gint64 qrtr_deadline_from_timeout (guint timeout_ms);
+
+G_GNUC_INTERNAL
+QrtrDeadlineTimer *qrtr_deadline_timer_add (GMainContext *context,
+                                            gint64        deadline,
+                                            GSourceFunc   callback,
+                                            gpointer      user_data);
+
+G_GNUC_INTERNAL
+void qrtr_deadline_timer_remove (QrtrDeadlineTimer *timer);
+
+#endif /* _LIBQRTR_GLIB_QRTR_DEADLINE_H_ */
@@ -0,0 +1,277 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <glib.h>
+
+#include "qrtr-loopback.h"
+#include "qrtr-utils.h"
+
+/* must be a power of two */
+#define LOOPBACK_RING_SIZE 256
+#define LOOPBACK_RING_MASK (LOOPBACK_RING_SIZE - 1)
+
+/* Ring slots, as in a bounded MPMC queue with per-slot sequence numbers: a
+ * slot is free for the producer claiming position 'pos' when its sequence
+ * is 'pos', and ready for the consumer when its sequence is 'pos + 1'. */
+typedef struct {
+    volatile gint  sequence;
+    guint32        node_id;
+    guint32        port;
+    GBytes        *message;
+} Slot;
+
+/* The endpoint is the source itself, so that it is kept around while being
+ * dispatched even if freed by the callback. */
+struct _QrtrLoopback {
+    GSource           source;
+    guint64           key;
+    QrtrLoopbackFunc  callback;
+    gpointer          user_data;
+    guint             max_dispatch;
+    volatile gint     wakeup_pending;
+    /* next position for producers */
+    volatile gint     head;
+    /* next position for the consumer */
+    gint              tail;
+    Slot              slots[LOOPBACK_RING_SIZE];
+};
+
+/* (node, port) -> QrtrLoopback; senders only need the reader lock, so they
+ * never block each other */
+static GRWLock        endpoints_lock;
+static GHashTable    *endpoints;
+/* so that senders skip the lookup when there are no endpoints at all */
+static volatile gint  n_endpoints;
+
+/*****************************************************************************/
+
+static gboolean
+ring_push (QrtrLoopback *self,
+           guint32       node_id,
+           guint32       port,
+           GBytes       *message)
+{
+    Slot *slot;
+    gint  pos;
+
+    pos = g_atomic_int_get (&self->head);
+    for (;;) {
+        gint diff;
+
+        slot = &self->slots[pos & LOOPBACK_RING_MASK];
+        diff = (gint) ((guint) g_atomic_int_get (&slot->sequence) - (guint) pos);
+        if (diff == 0) {
+            if (g_atomic_int_compare_and_exchange (&self->head, pos, (gint) ((guint) pos + 1)))
+                break;
+            pos = g_atomic_int_get (&self->head);
+        } else if (diff < 0)
+            return FALSE;
+        else
+            pos = g_atomic_int_get (&self->head);
+    }
+
+    slot->node_id = node_id;
+    slot->port = port;
+    slot->message = g_bytes_ref (message);
+    g_atomic_int_set (&slot->sequence, (gint) ((guint) pos + 1));
+    return TRUE;
+}
+
+static GBytes *
+ring_pop (QrtrLoopback *self,
+          guint32      *node_id,
+          guint32      *port)
+{
+    Slot   *slot;
+    GBytes *message;
+
+    slot = &self->slots[self->tail & LOOPBACK_RING_MASK];
+    if (g_atomic_int_get (&slot->sequence) != (gint) ((guint) self->tail + 1))
+        return NULL;
+
+    *node_id = slot->node_id;
+    *port = slot->port;
+    message = slot->message;
+    slot->message = NULL;
+    g_atomic_int_set (&slot->sequence, (gint) ((guint) self->tail + LOOPBACK_RING_SIZE));
+    self->tail = (gint) ((guint) self->tail + 1);
+    return message;
+}
+
+/*****************************************************************************/
+
+static gboolean
+loopback_dispatch (GSource     *source,
+                   GSourceFunc  callback,
+                   gpointer     user_data)
+{
+    QrtrLoopback *self = (QrtrLoopback *) source;
+    guint         n_messages;
+
+    /* cleared before draining, so that any message queued from now on
+     * schedules a new dispatch */
+    g_source_set_ready_time (source, -1);
+    g_atomic_int_set (&self->wakeup_pending, 0);
+
+    /* at most the given number of messages per main loop iteration, as
+     * for the messages received through the socket */
+    for (n_messages = 0; n_messages < self->max_dispatch; n_messages++) {
+        GBytes  *message;
+        guint32  node_id;
+        guint32  port;
+
+        message = ring_pop (self, &node_id, &port);
+        if (!message)
+            return G_SOURCE_CONTINUE;
+
+        self->callback (node_id, port, message, self->user_data);
+        g_bytes_unref (message);
+
+        /* the endpoint may have been freed by the callback */
+        if (g_source_is_destroyed (source))
+            return G_SOURCE_REMOVE;
+    }
+
+    g_source_set_ready_time (source, 0);
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+loopback_finalize (GSource *source)
+{
+    QrtrLoopback *self = (QrtrLoopback *) source;
+    GBytes       *message;
+    guint32       node_id;
+    guint32       port;
+
+    while ((message = ring_pop (self, &node_id, &port)) != NULL)
+        g_bytes_unref (message);
+}
+
+static GSourceFuncs loopback_source_funcs = {
+    NULL, /* prepare */
+    NULL, /* check */
+    loopback_dispatch,
+    loopback_finalize,
+    NULL, /* closure_callback */
+    NULL, /* closure_marshal */
+};
+
+/*****************************************************************************/
+
+QrtrLoopback *
+qrtr_loopback_new (guint32           node_id,
+                   guint32           port,
+                   GMainContext     *context,
+                   gint              priority,
+                   guint             max_dispatch,
+                   QrtrLoopbackFunc  callback,
+                   gpointer          user_data)
+{
+    QrtrLoopback *self;
+    guint         i;
+
+    g_assert (max_dispatch > 0);
+
+    self = (QrtrLoopback *) g_source_new (&loopback_source_funcs, sizeof (QrtrLoopback));
+    self->key = qrtr_address_key (node_id, port);
+    self->callback = callback;
+    self->user_data = user_data;
+    self->max_dispatch = max_dispatch;
+    for (i = 0; i < LOOPBACK_RING_SIZE; i++)
+        self->slots[i].sequence = (gint) i;
+    g_source_set_priority ((GSource *) self, priority);
+    g_source_set_name ((GSource *) self, "qrtr loopback");
+    g_source_attach ((GSource *) self, context);
+
+    g_rw_lock_writer_lock (&endpoints_lock);
+    if (!endpoints)
+        endpoints = g_hash_table_new (g_int64_hash, g_int64_equal);
+    /* the kernel doesn't allow binding the same address twice */
+    g_assert (!g_hash_table_contains (endpoints, &self->key));
+    g_hash_table_insert (endpoints, &self->key, self);
+    g_atomic_int_inc (&n_endpoints);
+    g_rw_lock_writer_unlock (&endpoints_lock);
+
+    return self;
+}
+
+void
+qrtr_loopback_free (QrtrLoopback *self)
+{
+    /* once removed, no sender can access the endpoint any more */
+    g_rw_lock_writer_lock (&endpoints_lock);
+    g_hash_table_remove (endpoints, &self->key);
+    g_atomic_int_add (&n_endpoints, -1);
+    g_rw_lock_writer_unlock (&endpoints_lock);
+
+    g_source_destroy ((GSource *) self);
+    g_source_unref ((GSource *) self);
+}
+
+/* Either the message or its data are given; the data are copied into a new
+ * message only once an endpoint is found. */
+static QrtrLoopbackSendResult
+loopback_send (guint32        src_node_id,
+               guint32        src_port,
+               guint32        dst_node_id,
+               guint32        dst_port,
+               GBytes        *message,
+               gconstpointer  data,
+               gsize          size)
+{
+    g_autoptr(GBytes)       copy = NULL;
+    QrtrLoopback           *endpoint;
+    QrtrLoopbackSendResult  result = QRTR_LOOPBACK_SEND_NO_ENDPOINT;
+    guint64                 key;
+
+    if (g_atomic_int_get (&n_endpoints) == 0)
+        return QRTR_LOOPBACK_SEND_NO_ENDPOINT;
+
+    key = qrtr_address_key (dst_node_id, dst_port);
+
+    g_rw_lock_reader_lock (&endpoints_lock);
+    endpoint = endpoints ? g_hash_table_lookup (endpoints, &key) : NULL;
+    if (endpoint) {
+        if (!message)
+            message = copy = g_bytes_new (data, size);
+        if (!ring_push (endpoint, src_node_id, src_port, message))
+            result = QRTR_LOOPBACK_SEND_FULL;
+        else {
+            result = QRTR_LOOPBACK_SEND_QUEUED;
+            /* only the first message since the last dispatch wakes up the
+             * consumer */
+            if (g_atomic_int_compare_and_exchange (&endpoint->wakeup_pending, 0, 1))
+                g_source_set_ready_time ((GSource *) endpoint, 0);
+        }
+    }
+    g_rw_lock_reader_unlock (&endpoints_lock);
+
+    return result;
+}
+
+QrtrLoopbackSendResult
+qrtr_loopback_send (guint32  src_node_id,
+                    guint32  src_port,
+                    guint32  dst_node_id,
+                    guint32  dst_port,
+                    GBytes  *message)
+{
+    return loopback_send (src_node_id, src_port, dst_node_id, dst_port, message, NULL, 0);
+}
+
+QrtrLoopbackSendResult
+qrtr_loopback_send_data (guint32        src_node_id,
+                         guint32        src_port,
+                         guint32        dst_node_id,
+                         guint32        dst_port,
+                         gconstpointer  data,
+                         gsize          size)
+{
+    return loopback_send (src_node_id, src_port, dst_node_id, dst_port, NULL, data, size);
+}
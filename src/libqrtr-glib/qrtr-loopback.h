@@ -0,0 +1,76 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_LOOPBACK_H_
+#define _LIBQRTR_GLIB_QRTR_LOOPBACK_H_
+
+#if !defined (LIBQRTR_GLIB_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <glib.h>
+
+/*
+ * The loopback registry keeps track of the QRTR addresses (node, port) bound
+ * by the servers of this same process, so that requests sent to them from
+ * this process are handed over in memory instead of going through the
+ * kernel. Only servers register endpoints: they are few, and they apply no
+ * filtering to the messages received, while clients filter and budget the
+ * messages in their socket. Replies to clients go through the kernel.
+ *
+ * Each endpoint has a bounded lock-free ring where any thread may queue
+ * messages, and which is drained in the main context of the endpoint, at
+ * most the given number of messages per main loop iteration. The endpoint
+ * sockets are still bound in the kernel, so the address can't be reused by
+ * anyone else, and messages from other processes still arrive through the
+ * socket.
+ */
+
+typedef struct _QrtrLoopback QrtrLoopback;
+
+typedef void (* QrtrLoopbackFunc) (guint32   node_id,
+                                   guint32   port,
+                                   GBytes   *message,
+                                   gpointer  user_data);
+
+typedef enum {
+    QRTR_LOOPBACK_SEND_NO_ENDPOINT,
+    QRTR_LOOPBACK_SEND_QUEUED,
+    QRTR_LOOPBACK_SEND_FULL
+} QrtrLoopbackSendResult;
+
+G_GNUC_INTERNAL
+QrtrLoopback *qrtr_loopback_new (guint32           node_id,
+                                 guint32           port,
+                                 GMainContext     *context,
+                                 gint              priority,
+                                 guint             max_dispatch,
+                                 QrtrLoopbackFunc  callback,
+                                 gpointer          user_data);
+
+G_GNUC_INTERNAL
+void qrtr_loopback_free (QrtrLoopback *self);
+
+G_GNUC_INTERNAL
+QrtrLoopbackSendResult qrtr_loopback_send (guint32  src_node_id,
+                                           guint32  src_port,
+                                           guint32  dst_node_id,
+                                           guint32  dst_port,
+                                           GBytes  *message);
+
+/* Same as qrtr_loopback_send(), but the message is only copied if there is
+ * an endpoint for the destination. */
+G_GNUC_INTERNAL
+QrtrLoopbackSendResult qrtr_loopback_send_data (guint32        src_node_id,
+                                                guint32        src_port,
+                                                guint32        dst_node_id,
+                                                guint32        dst_port,
+                                                gconstpointer  data,
+                                                gsize          size);
+
+#endif /* _LIBQRTR_GLIB_QRTR_LOOPBACK_H_ */
@@ -18,6 +18,7 @@
 #include <gmodule.h>
 
 #include "qrtr-bus.h"
+#include "qrtr-deadline.h"
 #include "qrtr-node.h"
 
 G_DEFINE_TYPE (QrtrNode, qrtr_node, G_TYPE_OBJECT)
@@ -32,6 +33,8 @@ enum {
 enum {
     SIGNAL_SERVICE_ADDED,
     SIGNAL_SERVICE_REMOVED,
+    SIGNAL_SERVICE_INFO_ADDED,
+    SIGNAL_SERVICE_INFO_REMOVED,
     SIGNAL_REMOVED,
     SIGNAL_LAST
 };
@@ -42,26 +45,44 @@ static guint       signals   [SIGNAL_LAST] = { 0 };
 struct _QrtrNodePrivate {
     QrtrBus   *bus;
     guint32    node_id;
-    guint      node_removed_id;
     gboolean   removed;
 
-    /* Holds QrtrNodeServiceInfo entries */
-    GList *service_list;
+    /* Holds QrtrNodeServiceInfo entries, in order of addition */
+    GQueue service_list;
     /* Maps service numbers to a list of service entries */
     GHashTable *service_index;
-    /* Maps port number to service entry (should only be one) */
+    /* Maps port number to the link of the service entry in the service list
+     * (should only be one) */
     GHashTable *port_index;
 
     /* Array of QrtrServiceWaiters currently registered. */
     GPtrArray *waiters;
+    /* Maps sets of services to the QrtrServiceWaiter waiting for them */
+    GHashTable *waiter_index;
 };
 
+/* One waiter per set of services; identical waits share the waiter, so that
+ * the services are checked once for all of them. */
 typedef struct {
+    QrtrNode *self;
+    /* sorted and without duplicates */
     GArray   *services;
-    GTask    *task;
-    GSource  *timeout_source;
+    /* position in the waiters array, for constant time removal */
+    guint     index;
+    /* ServiceWaits, one per caller */
+    GQueue    waits;
 } QrtrServiceWaiter;
 
+/* The timeout and cancellable sources of each caller share the ownership of
+ * the task with the waiter; whichever completes it first takes it. */
+typedef struct {
+    QrtrServiceWaiter *waiter;
+    GTask             *task;
+    GList              link;
+    QrtrDeadlineTimer *timer;
+    GSource           *cancellable_source;
+} ServiceWait;
+
 /* used to avoid calling the free function when values are overwritten
  * in the service index */
 typedef struct {
@@ -70,60 +91,141 @@ typedef struct {
 
 /*****************************************************************************/
 
-static void
-node_removed_cb (QrtrNode *self,
-                 guint     node_id)
+static void service_waiter_take_tasks (QrtrServiceWaiter *waiter,
+                                       GPtrArray         *tasks);
+
+void
+qrtr_node_set_removed (QrtrNode *self)
 {
-    guint i;
+    g_autoptr(GPtrArray) tasks = NULL;
+    guint                i;
 
-    if (node_id != self->priv->node_id)
+    if (self->priv->removed)
         return;
 
     self->priv->removed = TRUE;
 
-    for (i = 0; i < self->priv->waiters->len; i++) {
-        QrtrServiceWaiter *waiter;
+    /* Take all the waiters before completing any, as completing a task may
+     * run user code that modifies the waiters. */
+    tasks = g_ptr_array_new ();
+    while (self->priv->waiters->len > 0)
+        service_waiter_take_tasks (g_ptr_array_index (self->priv->waiters, self->priv->waiters->len - 1), tasks);
 
-        waiter = g_ptr_array_index (self->priv->waiters, i);
-        g_task_return_new_error (waiter->task,
+    for (i = 0; i < tasks->len; i++) {
+        GTask *task = g_ptr_array_index (tasks, i);
+
+        g_task_return_new_error (task,
                                  G_IO_ERROR,
                                  G_IO_ERROR_CLOSED,
                                  "QRTR node was removed from the bus");
+        g_object_unref (task);
     }
-    /* waiters was instantiated with qrtr_service_waiter_free as its free function,
-     * so when we get rid of the contents, all of the constitutent waiter entries
-     * (and their tasks) will be unreffed as well. */
-    g_ptr_array_remove_range (self->priv->waiters, 0, self->priv->waiters->len);
 
     g_signal_emit (self, signals[SIGNAL_REMOVED], 0);
 }
 
 /*****************************************************************************/
 
+static guint
+services_hash (const GArray *services)
+{
+    guint hash = 5381;
+    guint i;
+
+    for (i = 0; i < services->len; i++)
+        hash = hash * 33 + g_array_index (services, guint32, i);
+    return hash;
+}
+
+static gboolean
+services_equal (const GArray *a,
+                const GArray *b)
+{
+    return (a->len == b->len &&
+            memcmp (a->data, b->data, a->len * sizeof (guint32)) == 0);
+}
+
+static gint
+services_compare (const guint32 *a,
+                  const guint32 *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
 static void
-qrtr_service_waiter_free (QrtrServiceWaiter *waiter)
+service_waiter_remove (QrtrServiceWaiter *waiter)
 {
+    QrtrNode *self = waiter->self;
+
+    g_assert (g_queue_is_empty (&waiter->waits));
+
+    /* The last waiter is moved to the removed position */
+    g_ptr_array_remove_index_fast (self->priv->waiters, waiter->index);
+    if (waiter->index < self->priv->waiters->len)
+        ((QrtrServiceWaiter *) g_ptr_array_index (self->priv->waiters, waiter->index))->index = waiter->index;
+    g_hash_table_remove (self->priv->waiter_index, waiter->services);
+
     g_array_unref (waiter->services);
-    g_object_unref (waiter->task);
-    if (waiter->timeout_source) {
-        g_source_destroy (waiter->timeout_source);
-        g_source_unref (waiter->timeout_source);
-    }
     g_slice_free (QrtrServiceWaiter, waiter);
 }
 
+static GTask *
+service_wait_take_task (ServiceWait *wait)
+{
+    QrtrServiceWaiter *waiter = wait->waiter;
+    GTask             *task;
+
+    g_queue_unlink (&waiter->waits, &wait->link);
+    if (g_queue_is_empty (&waiter->waits))
+        service_waiter_remove (waiter);
+
+    if (wait->timer)
+        qrtr_deadline_timer_remove (wait->timer);
+    if (wait->cancellable_source) {
+        g_source_destroy (wait->cancellable_source);
+        g_source_unref (wait->cancellable_source);
+    }
+
+    task = wait->task;
+    g_slice_free (ServiceWait, wait);
+    return task;
+}
+
+/* The waiter is freed once all the tasks are taken */
+static void
+service_waiter_take_tasks (QrtrServiceWaiter *waiter,
+                           GPtrArray         *tasks)
+{
+    guint n_waits;
+
+    for (n_waits = waiter->waits.length; n_waits > 0; n_waits--)
+        g_ptr_array_add (tasks, service_wait_take_task (g_queue_peek_head (&waiter->waits)));
+}
+
 static gboolean
-service_waiter_timeout_cb (QrtrServiceWaiter *waiter)
+service_wait_timeout_cb (ServiceWait *wait)
 {
-    QrtrNode *self;
+    GTask *task;
 
-    self = g_task_get_source_object (waiter->task);
-    g_task_return_new_error (waiter->task,
+    task = service_wait_take_task (wait);
+    g_task_return_new_error (task,
                              G_IO_ERROR,
                              G_IO_ERROR_TIMED_OUT,
                              "QRTR services did not appear on the bus");
-    /* This takes care of unreffing the task. */
-    g_ptr_array_remove_fast (self->priv->waiters, waiter);
+    g_object_unref (task);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+service_wait_cancelled_cb (GCancellable *cancellable,
+                           ServiceWait  *wait)
+{
+    GTask *task;
+
+    task = service_wait_take_task (wait);
+    g_task_return_error_if_cancelled (task);
+    g_object_unref (task);
 
     return G_SOURCE_REMOVE;
 }
@@ -131,8 +233,12 @@ service_waiter_timeout_cb (QrtrServiceWaiter *waiter)
 static void
 dispatch_pending_waiters (QrtrNode *self)
 {
-    guint i;
+    g_autoptr(GPtrArray) tasks = NULL;
+    guint                i;
 
+    /* Take all the satisfied waiters before completing any, as completing a
+     * task may run user code that modifies the waiters. */
+    tasks = g_ptr_array_new ();
     for (i = 0; i < self->priv->waiters->len;) {
         QrtrServiceWaiter *waiter;
         guint j;
@@ -149,13 +255,18 @@ dispatch_pending_waiters (QrtrNode *self)
             }
         }
 
-        if (should_dispatch) {
-            g_task_return_boolean (waiter->task, TRUE);
-            /* This takes care of unreffing the task. */
-            g_ptr_array_remove_index_fast (self->priv->waiters, i);
-        } else {
+        /* when taken, the last waiter is moved to this position */
+        if (should_dispatch)
+            service_waiter_take_tasks (waiter, tasks);
+        else
             i++;
-        }
+    }
+
+    for (i = 0; i < tasks->len; i++) {
+        GTask *task = g_ptr_array_index (tasks, i);
+
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
     }
 }
 
@@ -206,6 +317,35 @@ qrtr_node_service_info_get_instance (QrtrNodeServiceInfo *info)
     return info->instance;
 }
 
+QrtrNodeServiceInfo *
+qrtr_node_service_info_new (guint32 service,
+                            guint32 port,
+                            guint32 version,
+                            guint32 instance)
+{
+    QrtrNodeServiceInfo *info;
+
+    info = g_slice_new (QrtrNodeServiceInfo);
+    info->service = service;
+    info->port = port;
+    info->version = version;
+    info->instance = instance;
+    return info;
+}
+
+gboolean
+qrtr_node_service_info_match (const QrtrNodeServiceInfo *info,
+                              guint32                    service,
+                              guint32                    min_version,
+                              guint32                    max_version,
+                              guint32                    instance)
+{
+    return (info->service == service &&
+            info->version >= min_version &&
+            info->version <= max_version &&
+            (instance == QRTR_NODE_INSTANCE_ANY || info->instance == instance));
+}
+
 static QrtrNodeServiceInfo *
 node_service_info_copy (const QrtrNodeServiceInfo *src)
 {
@@ -256,6 +396,11 @@ service_index_remove_info (GHashTable          *service_index,
         return;
 
     service_instances->list = g_list_remove (service_instances->list, info);
+
+    /* don't keep empty entries around, so that the index only reports
+     * services which are really available */
+    if (!service_instances->list)
+        g_hash_table_remove (service_index, GUINT_TO_POINTER (service));
 }
 
 void
@@ -266,17 +411,32 @@ qrtr_node_add_service_info (QrtrNode *self,
                             guint32   instance)
 {
     QrtrNodeServiceInfo *info;
+    GList               *link;
+
+    /* Servers are uniquely identified by their port, so the add operation
+     * is really an upsert keyed by port number. */
+    link = g_hash_table_lookup (self->priv->port_index, GUINT_TO_POINTER (port));
+    if (link) {
+        info = link->data;
+        /* re-announcement of an already known server, e.g. after a new
+         * lookup request; nothing to do */
+        if (qrtr_node_service_info_match (info, service, version, version, instance))
+            return;
+
+        /* the port is now used by a different server, so the old one is gone */
+        g_debug ("[qrtr node@%u]: port %u reused: service %u replaced by service %u",
+                 self->priv->node_id, port, info->service, service);
+        qrtr_node_remove_service_info (self, info->service, port, info->version, info->instance);
+    }
 
-    info = g_slice_new (QrtrNodeServiceInfo);
-    info->service = service;
-    info->port = port;
-    info->version = version;
-    info->instance = instance;
-    self->priv->service_list = g_list_append (self->priv->service_list, info);
+    info = qrtr_node_service_info_new (service, port, version, instance);
+    g_queue_push_tail (&self->priv->service_list, info);
     service_index_add_info (self->priv->service_index, service, info);
-    g_hash_table_insert (self->priv->port_index, GUINT_TO_POINTER (port), info);
+    g_hash_table_insert (self->priv->port_index, GUINT_TO_POINTER (port), g_queue_peek_tail_link (&self->priv->service_list));
 
     g_signal_emit (self, signals[SIGNAL_SERVICE_ADDED], 0, service);
+    if (g_signal_has_handler_pending (self, signals[SIGNAL_SERVICE_INFO_ADDED], 0, FALSE))
+        g_signal_emit (self, signals[SIGNAL_SERVICE_INFO_ADDED], 0, self->priv->node_id, info);
     dispatch_pending_waiters (self);
 }
 
@@ -288,20 +448,28 @@ qrtr_node_remove_service_info (QrtrNode *self,
                                guint32   instance)
 {
     QrtrNodeServiceInfo *info;
+    GList               *link;
 
-    info = g_hash_table_lookup (self->priv->port_index, GUINT_TO_POINTER (port));
-    if (!info) {
+    link = g_hash_table_lookup (self->priv->port_index, GUINT_TO_POINTER (port));
+    if (!link) {
         g_info ("[qrtr node@%u]: tried to remove unknown service %u, port %u",
                 self->priv->node_id, service, port);
         return;
     }
+    info = link->data;
+
+    /* the port is the key; report the service that was really registered */
+    service = info->service;
 
     service_index_remove_info (self->priv->service_index, service, info);
     g_hash_table_remove (self->priv->port_index, GUINT_TO_POINTER (port));
-    self->priv->service_list = g_list_remove (self->priv->service_list, info);
-    qrtr_node_service_info_free (info);
+    g_queue_delete_link (&self->priv->service_list, link);
 
     g_signal_emit (self, signals[SIGNAL_SERVICE_REMOVED], 0, service);
+    /* the info is no longer in the node, but still valid while emitting */
+    if (g_signal_has_handler_pending (self, signals[SIGNAL_SERVICE_INFO_REMOVED], 0, FALSE))
+        g_signal_emit (self, signals[SIGNAL_SERVICE_INFO_REMOVED], 0, self->priv->node_id, info);
+    qrtr_node_service_info_free (info);
 }
 
 /*****************************************************************************/
@@ -329,16 +497,63 @@ qrtr_node_lookup_port (QrtrNode *self,
     return (info) ? (gint32)info->port : -1;
 }
 
+QrtrNodeServiceInfo *
+qrtr_node_peek_service_info (QrtrNode *self,
+                             guint32   service,
+                             guint32   min_version,
+                             guint32   max_version,
+                             guint32   instance)
+{
+    ListHolder *service_instances;
+    GList      *l;
+
+    g_return_val_if_fail (QRTR_IS_NODE (self), NULL);
+
+    service_instances = g_hash_table_lookup (self->priv->service_index,
+                                             GUINT_TO_POINTER (service));
+    if (!service_instances)
+        return NULL;
+
+    /* the list is sorted by version, so iterate from the last one */
+    for (l = g_list_last (service_instances->list); l; l = g_list_previous (l)) {
+        QrtrNodeServiceInfo *info = l->data;
+
+        if (info->version > max_version)
+            continue;
+        if (info->version < min_version)
+            break;
+        if (instance == QRTR_NODE_INSTANCE_ANY || info->instance == instance)
+            return info;
+    }
+
+    return NULL;
+}
+
+gint32
+qrtr_node_lookup_port_full (QrtrNode *self,
+                            guint32   service,
+                            guint32   min_version,
+                            guint32   max_version,
+                            guint32   instance)
+{
+    QrtrNodeServiceInfo *info;
+
+    g_return_val_if_fail (QRTR_IS_NODE (self), -1);
+
+    info = qrtr_node_peek_service_info (self, service, min_version, max_version, instance);
+    return info ? (gint32)info->port : -1;
+}
+
 gint32
 qrtr_node_lookup_service (QrtrNode *self,
                           guint32   port)
 {
-    QrtrNodeServiceInfo *info;
+    GList *link;
 
     g_return_val_if_fail (QRTR_IS_NODE (self), -1);
 
-    info = g_hash_table_lookup (self->priv->port_index, GUINT_TO_POINTER (port));
-    return info ? (gint32)info->service : -1;
+    link = g_hash_table_lookup (self->priv->port_index, GUINT_TO_POINTER (port));
+    return link ? (gint32)((QrtrNodeServiceInfo *)link->data)->service : -1;
 }
 
 /*****************************************************************************/
@@ -348,7 +563,7 @@ qrtr_node_peek_service_info_list (QrtrNode *self)
 {
     g_return_val_if_fail (QRTR_IS_NODE (self), NULL);
 
-    return self->priv->service_list;
+    return self->priv->service_list.head;
 }
 
 GList *
@@ -356,7 +571,7 @@ qrtr_node_get_service_info_list (QrtrNode *self)
 {
     g_return_val_if_fail (QRTR_IS_NODE (self), NULL);
 
-    return g_list_copy_deep (self->priv->service_list, (GCopyFunc)node_service_info_copy, NULL);
+    return g_list_copy_deep (self->priv->service_list.head, (GCopyFunc)node_service_info_copy, NULL);
 }
 
 guint32
@@ -394,23 +609,29 @@ qrtr_node_wait_for_services_finish (QrtrNode      *self,
 }
 
 void
-qrtr_node_wait_for_services (QrtrNode            *self,
-                             GArray              *services,
-                             guint                timeout_ms,
-                             GCancellable        *cancellable,
-                             GAsyncReadyCallback  callback,
-                             gpointer             user_data)
+qrtr_node_wait_for_services_until (QrtrNode            *self,
+                                   GArray              *services,
+                                   gint64               deadline,
+                                   GCancellable        *cancellable,
+                                   GAsyncReadyCallback  callback,
+                                   gpointer             user_data)
 {
+    g_autoptr(GArray)  key = NULL;
     GTask             *task;
     QrtrServiceWaiter *waiter;
+    ServiceWait       *wait;
     guint              i;
     gboolean           services_present = TRUE;
 
     g_return_if_fail (QRTR_IS_NODE (self));
-    g_return_if_fail (timeout_ms > 0);
 
     task = g_task_new (self, cancellable, callback, user_data);
 
+    if (g_task_return_error_if_cancelled (task)) {
+        g_object_unref (task);
+        return;
+    }
+
     if (self->priv->removed) {
         g_task_return_new_error (task,
                                  G_IO_ERROR,
@@ -436,15 +657,60 @@ qrtr_node_wait_for_services (QrtrNode            *self,
         return;
     }
 
-    waiter = g_slice_new0 (QrtrServiceWaiter);
-    waiter->services = g_array_ref (services);
-    waiter->task = task;
-    waiter->timeout_source = g_timeout_source_new (timeout_ms);
-    g_source_set_callback (waiter->timeout_source, (GSourceFunc)service_waiter_timeout_cb,
-                           waiter, NULL);
-    g_source_attach (waiter->timeout_source, g_main_context_get_thread_default ());
+    /* Build the key of the waiter: the same services, sorted, without
+     * duplicates */
+    key = g_array_sized_new (FALSE, FALSE, sizeof (guint32), services->len);
+    g_array_append_vals (key, services->data, services->len);
+    g_array_sort (key, (GCompareFunc)services_compare);
+    for (i = 1; i < key->len;) {
+        if (g_array_index (key, guint32, i) == g_array_index (key, guint32, i - 1))
+            g_array_remove_index (key, i);
+        else
+            i++;
+    }
 
-    g_ptr_array_add (self->priv->waiters, waiter);
+    /* Reuse the waiter of an identical wait, if any */
+    waiter = g_hash_table_lookup (self->priv->waiter_index, key);
+    if (!waiter) {
+        waiter = g_slice_new0 (QrtrServiceWaiter);
+        waiter->self = self;
+        waiter->services = g_steal_pointer (&key);
+        g_queue_init (&waiter->waits);
+        waiter->index = self->priv->waiters->len;
+        g_ptr_array_add (self->priv->waiters, waiter);
+        g_hash_table_insert (self->priv->waiter_index, waiter->services, waiter);
+    }
+
+    wait = g_slice_new0 (ServiceWait);
+    wait->waiter = waiter;
+    wait->task = task;
+    wait->link.data = wait;
+    g_queue_push_tail_link (&waiter->waits, &wait->link);
+
+    wait->timer = qrtr_deadline_timer_add (g_main_context_get_thread_default (), deadline,
+                                           (GSourceFunc)service_wait_timeout_cb, wait);
+
+    /* Release the wait as soon as the operation is cancelled */
+    if (cancellable) {
+        wait->cancellable_source = g_cancellable_source_new (cancellable);
+        g_source_set_callback (wait->cancellable_source, (GSourceFunc)service_wait_cancelled_cb,
+                               wait, NULL);
+        g_source_attach (wait->cancellable_source, g_main_context_get_thread_default ());
+    }
+}
+
+void
+qrtr_node_wait_for_services (QrtrNode            *self,
+                             GArray              *services,
+                             guint                timeout_ms,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data)
+{
+    g_return_if_fail (timeout_ms > 0);
+
+    qrtr_node_wait_for_services_until (self, services, qrtr_deadline_from_timeout (timeout_ms),
+                                       cancellable, callback, user_data);
 }
 
 /*****************************************************************************/
@@ -458,7 +724,9 @@ qrtr_node_init (QrtrNode *self)
     self->priv->service_index = g_hash_table_new_full (g_direct_hash, g_direct_equal,
                                                        NULL, (GDestroyNotify)list_holder_free);
     self->priv->port_index = g_hash_table_new (g_direct_hash, g_direct_equal);
-    self->priv->waiters = g_ptr_array_new_with_free_func ((GDestroyNotify)qrtr_service_waiter_free);
+    g_queue_init (&self->priv->service_list);
+    self->priv->waiters = g_ptr_array_new ();
+    self->priv->waiter_index = g_hash_table_new ((GHashFunc)services_hash, (GEqualFunc)services_equal);
 }
 
 static void
@@ -473,10 +741,6 @@ set_property (GObject      *object,
     case PROP_BUS:
         g_assert (!self->priv->bus);
         self->priv->bus = g_value_dup_object (value);
-        self->priv->node_removed_id = g_signal_connect_swapped (self->priv->bus,
-                                                                QRTR_BUS_SIGNAL_NODE_REMOVED,
-                                                                G_CALLBACK (node_removed_cb),
-                                                                self);
         break;
     case PROP_NODE_ID:
         self->priv->node_id = (guint32) g_value_get_uint (value);
@@ -513,16 +777,13 @@ dispose (GObject *object)
 {
     QrtrNode *self = QRTR_NODE (object);
 
-    if (self->priv->node_removed_id) {
-        g_signal_handler_disconnect (self->priv->bus, self->priv->node_removed_id);
-        self->priv->node_removed_id = 0;
-    }
     g_clear_object (&self->priv->bus);
 
     /* We shouldn't have any waiters because they should have been removed when the
      * node was removed from the bus, and they hold references to self. */
     g_assert (self->priv->waiters->len == 0);
     g_clear_pointer (&self->priv->waiters, (GDestroyNotify)g_ptr_array_unref);
+    g_clear_pointer (&self->priv->waiter_index, g_hash_table_unref);
 
     G_OBJECT_CLASS (qrtr_node_parent_class)->dispose (object);
 }
@@ -534,7 +795,7 @@ finalize (GObject *object)
 
     g_hash_table_unref (self->priv->service_index);
     g_hash_table_unref (self->priv->port_index);
-    g_list_free_full (self->priv->service_list, (GDestroyNotify)qrtr_node_service_info_free);
+    g_list_free_full (self->priv->service_list.head, (GDestroyNotify)qrtr_node_service_info_free);
 
     G_OBJECT_CLASS (qrtr_node_parent_class)->finalize (object);
 }
@@ -623,6 +884,61 @@ qrtr_node_class_init (QrtrNodeClass *klass)
                       1,
                       G_TYPE_UINT);
 
+    /**
+     * QrtrNode::service-info-added:
+     * @self: the #QrtrNode
+     * @node_id: the node ID
+     * @info: the #QrtrNodeServiceInfo of the service that was added
+     *
+     * The ::service-info-added signal is emitted when a new service registers
+     * on the QRTR node, right after #QrtrNode::service-added, with the full
+     * details of the new server.
+     *
+     * @info is owned by the node and must not be modified; it is valid until
+     * the service is removed, so copy it to keep it for longer.
+     *
+     * Since: 1.4
+     */
+    signals[SIGNAL_SERVICE_INFO_ADDED] =
+        g_signal_new (QRTR_NODE_SIGNAL_SERVICE_INFO_ADDED,
+                      G_OBJECT_CLASS_TYPE (G_OBJECT_CLASS (klass)),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL,
+                      NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      2,
+                      G_TYPE_UINT,
+                      QRTR_TYPE_NODE_SERVICE_INFO | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+    /**
+     * QrtrNode::service-info-removed:
+     * @self: the #QrtrNode
+     * @node_id: the node ID
+     * @info: the #QrtrNodeServiceInfo of the service that was removed
+     *
+     * The ::service-info-removed signal is emitted when a service deregisters
+     * from the QRTR node, right after #QrtrNode::service-removed, with the
+     * full details of the server that is gone.
+     *
+     * @info is only valid during the signal emission.
+     *
+     * Since: 1.4
+     */
+    signals[SIGNAL_SERVICE_INFO_REMOVED] =
+        g_signal_new (QRTR_NODE_SIGNAL_SERVICE_INFO_REMOVED,
+                      G_OBJECT_CLASS_TYPE (G_OBJECT_CLASS (klass)),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL,
+                      NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      2,
+                      G_TYPE_UINT,
+                      QRTR_TYPE_NODE_SERVICE_INFO | G_SIGNAL_TYPE_STATIC_SCOPE);
+
     /**
      * QrtrNode::node-removed:
      * @self: the #QrtrNode
@@ -97,6 +97,24 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC (QrtrNode, g_object_unref)
  */
 #define QRTR_NODE_SIGNAL_SERVICE_REMOVED "service-removed"
 
+/**
+ * QRTR_NODE_SIGNAL_SERVICE_INFO_ADDED:
+ *
+ * Symbol defining the #QrtrNode::service-info-added signal.
+ *
+ * Since: 1.4
+ */
+#define QRTR_NODE_SIGNAL_SERVICE_INFO_ADDED "service-info-added"
+
+/**
+ * QRTR_NODE_SIGNAL_SERVICE_INFO_REMOVED:
+ *
+ * Symbol defining the #QrtrNode::service-info-removed signal.
+ *
+ * Since: 1.4
+ */
+#define QRTR_NODE_SIGNAL_SERVICE_INFO_REMOVED "service-info-removed"
+
 /**
  * QRTR_NODE_SIGNAL_REMOVED:
  *
@@ -275,6 +293,65 @@ gint32 qrtr_node_lookup_port (QrtrNode *self,
 gint32 qrtr_node_lookup_service (QrtrNode *self,
                                  guint32   port);
 
+/**
+ * QRTR_NODE_INSTANCE_ANY:
+ *
+ * Wildcard instance number, to be used in lookups that should match any
+ * service instance.
+ *
+ * Since: 1.4
+ */
+#define QRTR_NODE_INSTANCE_ANY G_MAXUINT32
+
+/**
+ * qrtr_node_peek_service_info:
+ * @self: a #QrtrNode.
+ * @service: a service number.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ *
+ * If a server has announced itself for the given node and service number,
+ * with a version in the [@min_version, @max_version] range and matching the
+ * given @instance, return its service information.
+ *
+ * If multiple matching servers are registered, this method returns the one
+ * with the highest version number.
+ *
+ * Returns: (transfer none)(nullable): a #QrtrNodeServiceInfo, or %NULL if not
+ *  found. Do not free the returned object, it is owned by @self and is only
+ *  valid until the service is removed from the node.
+ *
+ * Since: 1.4
+ */
+QrtrNodeServiceInfo *qrtr_node_peek_service_info (QrtrNode *self,
+                                                  guint32   service,
+                                                  guint32   min_version,
+                                                  guint32   max_version,
+                                                  guint32   instance);
+
+/**
+ * qrtr_node_lookup_port_full:
+ * @self: a #QrtrNode.
+ * @service: a service number.
+ * @min_version: the minimum version number accepted.
+ * @max_version: the maximum version number accepted.
+ * @instance: an instance number, or %QRTR_NODE_INSTANCE_ANY.
+ *
+ * Same as qrtr_node_lookup_port(), but only considering servers with a
+ * version in the [@min_version, @max_version] range and matching the given
+ * @instance.
+ *
+ * Returns: the port number of the service in the node, or -1 if not found.
+ *
+ * Since: 1.4
+ */
+gint32 qrtr_node_lookup_port_full (QrtrNode *self,
+                                   guint32   service,
+                                   guint32   min_version,
+                                   guint32   max_version,
+                                   guint32   instance);
+
 /**
  * qrtr_node_wait_for_services:
  * @self: a #QrtrNode.
@@ -304,6 +381,34 @@ void qrtr_node_wait_for_services (QrtrNode            *self,
                                   GAsyncReadyCallback  callback,
                                   gpointer             user_data);
 
+/**
+ * qrtr_node_wait_for_services_until:
+ * @self: a #QrtrNode.
+ * @services: (in)(element-type guint32): a #GArray of service types
+ * @deadline: the monotonic time, as given by g_get_monotonic_time(), at which
+ *  to stop waiting for the services to be exposed in the node.
+ * @cancellable: a #GCancellable, or #NULL.
+ * @callback: a #GAsyncReadyCallback to call when the request is satisfied.
+ * @user_data: user data to pass to @callback.
+ *
+ * This is the same as qrtr_node_wait_for_services(), but with an absolute
+ * deadline instead of a relative timeout, so that chained operations can
+ * share the same deadline. Operations with the same deadline share the same
+ * timer.
+ *
+ * When the operation is finished @callback will be called. You can then call
+ * qrtr_node_wait_for_services_finish() to get the result of the
+ * operation.
+ *
+ * Since: 1.4
+ */
+void qrtr_node_wait_for_services_until (QrtrNode            *self,
+                                        GArray              *services,
+                                        gint64               deadline,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data);
+
 /**
  * qrtr_node_wait_for_services_finish:
  * @self: a #QrtrNode.
@@ -341,6 +446,22 @@ void qrtr_node_remove_service_info (QrtrNode *node,
                                     guint32   version,
                                     guint32   instance);
 
+G_GNUC_INTERNAL
+void qrtr_node_set_removed (QrtrNode *node);
+
+G_GNUC_INTERNAL
+QrtrNodeServiceInfo *qrtr_node_service_info_new (guint32 service,
+                                                 guint32 port,
+                                                 guint32 version,
+                                                 guint32 instance);
+
+G_GNUC_INTERNAL
+gboolean qrtr_node_service_info_match (const QrtrNodeServiceInfo *info,
+                                       guint32                    service,
+                                       guint32                    min_version,
+                                       guint32                    max_version,
+                                       guint32                    instance);
+
 #endif /* defined (LIBQRTR_GLIB_COMPILATION) */
 
 #endif /* _LIBQRTR_GLIB_QRTR_NODE_H_ */
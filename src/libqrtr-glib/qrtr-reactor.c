@@ -0,0 +1,315 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+
+#include "qrtr-reactor.h"
+
+/* max number of ready fds processed per source dispatch; the rest are kept
+ * for the next main loop iteration as the fds are level-triggered */
+#define REACTOR_MAX_EVENTS 64
+
+typedef struct _Reactor Reactor;
+
+typedef struct {
+    GSource   source;
+    Reactor  *reactor;
+    gint      epfd;
+} ReactorSource;
+
+struct _Reactor {
+    gint          ref_count;
+    GMainContext *context;
+    /* priority -> ReactorSource */
+    GHashTable   *sources;
+    /* removed watches can't be freed while dispatching, as they may still
+     * be in the list of events being processed */
+    guint         dispatching;
+    GSList       *graveyard;
+};
+
+struct _QrtrReactorWatch {
+    Reactor         *reactor;
+    ReactorSource   *source;
+    gint             fd;
+    gboolean         enabled;
+    QrtrReactorFunc  callback;
+    gpointer         user_data;
+};
+
+/* GMainContext -> Reactor */
+G_LOCK_DEFINE_STATIC (reactors);
+static GHashTable *reactors;
+
+/*****************************************************************************/
+
+static Reactor *
+reactor_ref (Reactor *reactor)
+{
+    G_LOCK (reactors);
+    reactor->ref_count++;
+    G_UNLOCK (reactors);
+    return reactor;
+}
+
+static void
+reactor_unref (Reactor *reactor)
+{
+    G_LOCK (reactors);
+    if (--reactor->ref_count > 0) {
+        G_UNLOCK (reactors);
+        return;
+    }
+    g_hash_table_remove (reactors, reactor->context);
+    G_UNLOCK (reactors);
+
+    g_assert (!reactor->dispatching);
+    g_assert (!reactor->graveyard);
+    g_hash_table_unref (reactor->sources);
+    g_main_context_unref (reactor->context);
+    g_slice_free (Reactor, reactor);
+}
+
+static void
+reactor_source_release (ReactorSource *source)
+{
+    g_source_destroy ((GSource *) source);
+    g_source_unref ((GSource *) source);
+}
+
+static Reactor *
+reactor_get (GMainContext *context)
+{
+    Reactor *reactor;
+
+    if (!context)
+        context = g_main_context_default ();
+
+    G_LOCK (reactors);
+    if (!reactors)
+        reactors = g_hash_table_new (g_direct_hash, g_direct_equal);
+    reactor = g_hash_table_lookup (reactors, context);
+    if (reactor)
+        reactor->ref_count++;
+    else {
+        reactor = g_slice_new0 (Reactor);
+        reactor->ref_count = 1;
+        reactor->context = g_main_context_ref (context);
+        reactor->sources = g_hash_table_new_full (g_direct_hash,
+                                                  g_direct_equal,
+                                                  NULL,
+                                                  (GDestroyNotify) reactor_source_release);
+        g_hash_table_insert (reactors, context, reactor);
+    }
+    G_UNLOCK (reactors);
+
+    return reactor;
+}
+
+/*****************************************************************************/
+
+static void
+watch_disable (QrtrReactorWatch *watch)
+{
+    if (!watch->enabled)
+        return;
+
+    /* may fail if the fd was already closed, nothing to do then */
+    epoll_ctl (watch->source->epfd, EPOLL_CTL_DEL, watch->fd, NULL);
+    watch->enabled = FALSE;
+}
+
+static gboolean
+watch_enable (QrtrReactorWatch  *watch,
+              ReactorSource     *source,
+              GError           **error)
+{
+    struct epoll_event event;
+
+    g_assert (!watch->enabled);
+
+    memset (&event, 0, sizeof (event));
+    event.events = EPOLLIN;
+    event.data.ptr = watch;
+    if (epoll_ctl (source->epfd, EPOLL_CTL_ADD, watch->fd, &event) < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Could not watch fd: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    watch->source = source;
+    watch->enabled = TRUE;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+reactor_source_dispatch (GSource     *source,
+                         GSourceFunc  callback,
+                         gpointer     user_data)
+{
+    ReactorSource      *self = (ReactorSource *) source;
+    Reactor            *reactor;
+    struct epoll_event  events[REACTOR_MAX_EVENTS];
+    gint                n_events;
+    gint                i;
+
+    /* only dispatched when the epoll fd is readable, so this just collects
+     * the ready fds, without iterating over all the registered ones */
+    n_events = epoll_wait (self->epfd, events, REACTOR_MAX_EVENTS, 0);
+    if (n_events < 0) {
+        if (errno != EINTR)
+            g_warning ("[qrtr] couldn't collect socket events: %s", g_strerror (errno));
+        return G_SOURCE_CONTINUE;
+    }
+
+    /* the last watch may be removed by the callbacks */
+    reactor = reactor_ref (self->reactor);
+    reactor->dispatching++;
+
+    for (i = 0; i < n_events; i++) {
+        QrtrReactorWatch *watch;
+
+        watch = (QrtrReactorWatch *) events[i].data.ptr;
+        /* removed, disabled or moved by a previous callback */
+        if (!watch->enabled || watch->source != self)
+            continue;
+        if (!watch->callback (watch->user_data))
+            watch_disable (watch);
+    }
+
+    if (--reactor->dispatching == 0)
+        g_slist_free_full (g_steal_pointer (&reactor->graveyard), g_free);
+    reactor_unref (reactor);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+reactor_source_finalize (GSource *source)
+{
+    ReactorSource *self = (ReactorSource *) source;
+
+    close (self->epfd);
+}
+
+static GSourceFuncs reactor_source_funcs = {
+    NULL, /* prepare */
+    NULL, /* check */
+    reactor_source_dispatch,
+    reactor_source_finalize,
+    NULL, /* closure_callback */
+    NULL, /* closure_marshal */
+};
+
+static ReactorSource *
+reactor_peek_source (Reactor  *reactor,
+                     gint      priority,
+                     GError  **error)
+{
+    ReactorSource *source;
+    gint           epfd;
+
+    source = g_hash_table_lookup (reactor->sources, GINT_TO_POINTER (priority));
+    if (source)
+        return source;
+
+    epfd = epoll_create1 (EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Could not create epoll instance: %s", g_strerror (errno));
+        return NULL;
+    }
+
+    source = (ReactorSource *) g_source_new (&reactor_source_funcs, sizeof (ReactorSource));
+    source->reactor = reactor;
+    source->epfd = epfd;
+    g_source_add_unix_fd ((GSource *) source, epfd, G_IO_IN);
+    g_source_set_priority ((GSource *) source, priority);
+    g_source_set_name ((GSource *) source, "qrtr reactor");
+    g_source_attach ((GSource *) source, reactor->context);
+    g_hash_table_insert (reactor->sources, GINT_TO_POINTER (priority), source);
+
+    return source;
+}
+
+/*****************************************************************************/
+
+QrtrReactorWatch *
+qrtr_reactor_watch_add (GMainContext     *context,
+                        gint              fd,
+                        gint              priority,
+                        QrtrReactorFunc   callback,
+                        gpointer          user_data,
+                        GError          **error)
+{
+    QrtrReactorWatch *watch;
+    ReactorSource    *source;
+
+    g_assert (fd >= 0);
+    g_assert (callback);
+
+    watch = g_new0 (QrtrReactorWatch, 1);
+    watch->reactor = reactor_get (context);
+    watch->fd = fd;
+    watch->callback = callback;
+    watch->user_data = user_data;
+
+    source = reactor_peek_source (watch->reactor, priority, error);
+    if (!source || !watch_enable (watch, source, error)) {
+        reactor_unref (watch->reactor);
+        g_free (watch);
+        return NULL;
+    }
+
+    return watch;
+}
+
+gboolean
+qrtr_reactor_watch_set_priority (QrtrReactorWatch  *watch,
+                                 gint               priority,
+                                 GError           **error)
+{
+    ReactorSource *source;
+
+    if (g_source_get_priority ((GSource *) watch->source) == priority)
+        return TRUE;
+
+    source = reactor_peek_source (watch->reactor, priority, error);
+    if (!source)
+        return FALSE;
+
+    if (!watch->enabled) {
+        /* a disabled watch is never enabled again */
+        watch->source = source;
+        return TRUE;
+    }
+
+    watch_disable (watch);
+    return watch_enable (watch, source, error);
+}
+
+void
+qrtr_reactor_watch_remove (QrtrReactorWatch *watch)
+{
+    Reactor *reactor;
+
+    reactor = watch->reactor;
+    watch_disable (watch);
+    if (reactor->dispatching)
+        reactor->graveyard = g_slist_prepend (reactor->graveyard, watch);
+    else
+        g_free (watch);
+    reactor_unref (reactor);
+}
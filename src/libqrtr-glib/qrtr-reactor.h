@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_REACTOR_H_
+#define _LIBQRTR_GLIB_QRTR_REACTOR_H_
+
+#if !defined (LIBQRTR_GLIB_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <gio/gio.h>
+#include <glib.h>
+
+/*
+ * The reactor multiplexes all the sockets of the library attached to the
+ * same main context in a single epoll instance, which is what the main
+ * context polls, instead of having one GSource (and one pollfd) per socket.
+ * There is one reactor source per main context and priority, so that the
+ * dispatch order between library sockets and other sources is kept.
+ *
+ * Watches are level-triggered: the callback is called once per main loop
+ * iteration while the fd is readable. If the callback returns FALSE, the fd
+ * is no longer watched, but the watch must still be removed by its owner.
+ */
+
+typedef struct _QrtrReactorWatch QrtrReactorWatch;
+
+typedef gboolean (* QrtrReactorFunc) (gpointer user_data);
+
+G_GNUC_INTERNAL
+QrtrReactorWatch *qrtr_reactor_watch_add (GMainContext    *context,
+                                          gint             fd,
+                                          gint             priority,
+                                          QrtrReactorFunc  callback,
+                                          gpointer         user_data,
+                                          GError         **error);
+
+G_GNUC_INTERNAL
+gboolean qrtr_reactor_watch_set_priority (QrtrReactorWatch  *watch,
+                                          gint               priority,
+                                          GError           **error);
+
+G_GNUC_INTERNAL
+void qrtr_reactor_watch_remove (QrtrReactorWatch *watch);
+
+#endif /* _LIBQRTR_GLIB_QRTR_REACTOR_H_ */
@@ -0,0 +1,839 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+/* recvmmsg() and sendmmsg() */
+#define _GNU_SOURCE
+
+#include <endian.h>
+#include <errno.h>
+#include <linux/qrtr.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+
+#include "qrtr-loopback.h"
+#include "qrtr-reactor.h"
+#include "qrtr-server.h"
+#include "qrtr-utils.h"
+
+/* number of messages received with a single system call; every message
+ * needs a buffer of the max size, so keep it small */
+#define SERVER_BATCH_SIZE  4
+/* max size of a QRTR message */
+#define SERVER_BUFFER_SIZE (64 * 1024)
+
+static void initable_iface_init (GInitableIface *iface);
+
+G_DEFINE_TYPE_EXTENDED (QrtrServer, qrtr_server, G_TYPE_OBJECT, 0,
+                        G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE, initable_iface_init))
+
+enum {
+    PROP_0,
+    PROP_SERVICE,
+    PROP_VERSION,
+    PROP_INSTANCE,
+    PROP_LAST
+};
+
+enum {
+    SIGNAL_REQUEST,
+    SIGNAL_PEER_REMOVED,
+    SIGNAL_LAST
+};
+
+static GParamSpec *properties[PROP_LAST];
+static guint       signals   [SIGNAL_LAST] = { 0 };
+
+typedef struct {
+    guint32         node_id;
+    guint32         port;
+    gpointer        data;
+    GDestroyNotify  destroy;
+} Peer;
+
+struct _QrtrServerPrivate {
+    guint32 service;
+    guint32 version;
+    guint32 instance;
+
+    /* local address */
+    guint32 node_id;
+    guint32 port;
+    gboolean published;
+
+    GSocket          *socket;
+    QrtrReactorWatch *watch;
+    QrtrLoopback     *loopback;
+
+    /* Peer -> Peer */
+    GHashTable *peers;
+
+    /* batched receive; the buffer is only allocated once a message is
+     * received, as many servers never get requests */
+    guint8               *buffer;
+    struct mmsghdr        msgs[SERVER_BATCH_SIZE];
+    struct iovec          iovs[SERVER_BATCH_SIZE];
+    struct sockaddr_qrtr  addrs[SERVER_BATCH_SIZE];
+};
+
+/*****************************************************************************/
+
+static guint
+peer_hash (const Peer *peer)
+{
+    return (peer->node_id * 31) ^ peer->port;
+}
+
+static gboolean
+peer_equal (const Peer *a,
+            const Peer *b)
+{
+    return a->node_id == b->node_id && a->port == b->port;
+}
+
+static void
+peer_free (Peer *peer)
+{
+    if (peer->destroy)
+        peer->destroy (peer->data);
+    g_slice_free (Peer, peer);
+}
+
+static Peer *
+peer_lookup (QrtrServer *self,
+             guint32     node_id,
+             guint32     port)
+{
+    Peer key;
+
+    key.node_id = node_id;
+    key.port = port;
+    return g_hash_table_lookup (self->priv->peers, &key);
+}
+
+static void
+peer_ensure (QrtrServer *self,
+             guint32     node_id,
+             guint32     port)
+{
+    Peer *peer;
+
+    if (peer_lookup (self, node_id, port))
+        return;
+
+    peer = g_slice_new0 (Peer);
+    peer->node_id = node_id;
+    peer->port = port;
+    g_hash_table_add (self->priv->peers, peer);
+}
+
+static void
+peer_remove (QrtrServer *self,
+             Peer       *peer)
+{
+    g_debug ("[qrtr server %u] peer %u:%u removed", self->priv->service, peer->node_id, peer->port);
+
+    /* the peer data is still available to the signal handlers */
+    g_signal_emit (self, signals[SIGNAL_PEER_REMOVED], 0, peer->node_id, peer->port);
+    /* the server may have been disposed by the signal handler */
+    if (self->priv->peers)
+        g_hash_table_remove (self->priv->peers, peer);
+}
+
+static void
+peers_remove_node (QrtrServer *self,
+                   guint32     node_id)
+{
+    g_autoptr(GPtrArray) removed = NULL;
+    GHashTableIter       iter;
+    Peer                *peer;
+    guint                i;
+
+    removed = g_ptr_array_new ();
+    g_hash_table_iter_init (&iter, self->priv->peers);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&peer, NULL)) {
+        if (peer->node_id == node_id)
+            g_ptr_array_add (removed, peer);
+    }
+
+    for (i = 0; i < removed->len && self->priv->peers; i++)
+        peer_remove (self, g_ptr_array_index (removed, i));
+}
+
+/*****************************************************************************/
+
+guint32
+qrtr_server_get_service (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->service;
+}
+
+guint32
+qrtr_server_get_version (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->version;
+}
+
+guint32
+qrtr_server_get_instance (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->instance;
+}
+
+guint32
+qrtr_server_get_node_id (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->node_id;
+}
+
+guint32
+qrtr_server_get_port (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->port;
+}
+
+guint
+qrtr_server_get_n_peers (QrtrServer *self)
+{
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+
+    return self->priv->peers ? g_hash_table_size (self->priv->peers) : 0;
+}
+
+gboolean
+qrtr_server_set_peer_data (QrtrServer     *self,
+                           guint32         node_id,
+                           guint32         port,
+                           gpointer        data,
+                           GDestroyNotify  destroy)
+{
+    Peer           *peer;
+    gpointer        old_data;
+    GDestroyNotify  old_destroy;
+
+    g_return_val_if_fail (QRTR_IS_SERVER (self), FALSE);
+
+    if (!self->priv->peers)
+        return FALSE;
+
+    peer = peer_lookup (self, node_id, port);
+    if (!peer)
+        return FALSE;
+
+    old_data = peer->data;
+    old_destroy = peer->destroy;
+    peer->data = data;
+    peer->destroy = destroy;
+    if (old_destroy)
+        old_destroy (old_data);
+    return TRUE;
+}
+
+gpointer
+qrtr_server_get_peer_data (QrtrServer *self,
+                           guint32     node_id,
+                           guint32     port)
+{
+    Peer *peer;
+
+    g_return_val_if_fail (QRTR_IS_SERVER (self), NULL);
+
+    if (!self->priv->peers)
+        return NULL;
+
+    peer = peer_lookup (self, node_id, port);
+    return peer ? peer->data : NULL;
+}
+
+/*****************************************************************************/
+
+static void
+fill_peer_address (struct sockaddr_qrtr *addr,
+                   guint32               node_id,
+                   guint32               port)
+{
+    memset (addr, 0, sizeof (*addr));
+    addr->sq_family = AF_QIPCRTR;
+    addr->sq_node = node_id;
+    addr->sq_port = port;
+}
+
+gboolean
+qrtr_server_send (QrtrServer  *self,
+                  guint32      node_id,
+                  guint32      port,
+                  GBytes      *message,
+                  GError     **error)
+{
+    struct sockaddr_qrtr  addr;
+    gconstpointer         data;
+    gsize                 size;
+
+    g_return_val_if_fail (QRTR_IS_SERVER (self), FALSE);
+    g_return_val_if_fail (message != NULL, FALSE);
+
+    if (!self->priv->socket) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                     "QRTR server is closed");
+        return FALSE;
+    }
+
+    switch (qrtr_loopback_send (self->priv->node_id, self->priv->port, node_id, port, message)) {
+    case QRTR_LOOPBACK_SEND_QUEUED:
+        return TRUE;
+    case QRTR_LOOPBACK_SEND_FULL:
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+                     "Failed to send QRTR message: loopback queue is full");
+        return FALSE;
+    case QRTR_LOOPBACK_SEND_NO_ENDPOINT:
+    default:
+        break;
+    }
+
+    fill_peer_address (&addr, node_id, port);
+    data = g_bytes_get_data (message, &size);
+    if (sendto (g_socket_get_fd (self->priv->socket), data, size, MSG_DONTWAIT,
+                (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+        g_set_error (error,
+                     G_IO_ERROR,
+                     g_io_error_from_errno (errno),
+                     "Failed to send QRTR message: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+send_pending (QrtrServer      *self,
+              struct mmsghdr  *msgs,
+              guint           *n_pending,
+              guint           *n_sent,
+              GError         **error)
+{
+    guint n_done = 0;
+
+    /* if not all the messages are sent, the next call reports why */
+    while (n_done < *n_pending) {
+        gint rc;
+
+        rc = sendmmsg (g_socket_get_fd (self->priv->socket), msgs + n_done, *n_pending - n_done, MSG_DONTWAIT);
+        if (rc < 0) {
+            g_set_error (error,
+                         G_IO_ERROR,
+                         g_io_error_from_errno (errno),
+                         "Failed to send QRTR message: %s", g_strerror (errno));
+            break;
+        }
+        n_done += (guint) rc;
+    }
+
+    *n_sent += n_done;
+    if (n_done < *n_pending) {
+        *n_pending = 0;
+        return FALSE;
+    }
+    *n_pending = 0;
+    return TRUE;
+}
+
+guint
+qrtr_server_send_batch (QrtrServer               *self,
+                        const QrtrServerMessage  *messages,
+                        guint                     n_messages,
+                        GError                  **error)
+{
+    struct mmsghdr        msgs[SERVER_BATCH_SIZE];
+    struct iovec          iovs[SERVER_BATCH_SIZE];
+    struct sockaddr_qrtr  addrs[SERVER_BATCH_SIZE];
+    guint                 n_pending = 0;
+    guint                 n_sent = 0;
+    guint                 i;
+
+    g_return_val_if_fail (QRTR_IS_SERVER (self), 0);
+    g_return_val_if_fail (messages != NULL || n_messages == 0, 0);
+
+    if (!self->priv->socket) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED,
+                     "QRTR server is closed");
+        return 0;
+    }
+
+    for (i = 0; i < n_messages; i++) {
+        const QrtrServerMessage *message = &messages[i];
+        gsize                    size;
+
+        /* Peers in this same process get their messages right away; this
+         * doesn't break the per-peer ordering as a peer is either always
+         * local or never. */
+        switch (qrtr_loopback_send (self->priv->node_id, self->priv->port,
+                                    message->node_id, message->port, message->message)) {
+        case QRTR_LOOPBACK_SEND_QUEUED:
+            n_sent++;
+            continue;
+        case QRTR_LOOPBACK_SEND_FULL:
+            if (send_pending (self, msgs, &n_pending, &n_sent, error))
+                g_set_error (error, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK,
+                             "Failed to send QRTR message: loopback queue is full");
+            return n_sent;
+        case QRTR_LOOPBACK_SEND_NO_ENDPOINT:
+        default:
+            break;
+        }
+
+        memset (&msgs[n_pending], 0, sizeof (msgs[n_pending]));
+        fill_peer_address (&addrs[n_pending], message->node_id, message->port);
+        iovs[n_pending].iov_base = (gpointer) g_bytes_get_data (message->message, &size);
+        iovs[n_pending].iov_len = size;
+        msgs[n_pending].msg_hdr.msg_name = &addrs[n_pending];
+        msgs[n_pending].msg_hdr.msg_namelen = sizeof (addrs[n_pending]);
+        msgs[n_pending].msg_hdr.msg_iov = &iovs[n_pending];
+        msgs[n_pending].msg_hdr.msg_iovlen = 1;
+        n_pending++;
+
+        if (n_pending == SERVER_BATCH_SIZE && !send_pending (self, msgs, &n_pending, &n_sent, error))
+            return n_sent;
+    }
+
+    send_pending (self, msgs, &n_pending, &n_sent, error);
+    return n_sent;
+}
+
+/*****************************************************************************/
+
+static void
+process_ctrl_packet (QrtrServer *self,
+                     gconstpointer data,
+                     gsize         size)
+{
+    struct qrtr_ctrl_pkt ctrl_packet;
+    Peer                *peer;
+
+    if (size < sizeof (ctrl_packet))
+        return;
+    memcpy (&ctrl_packet, data, sizeof (ctrl_packet));
+
+    switch (GUINT32_FROM_LE (ctrl_packet.cmd)) {
+    case QRTR_TYPE_DEL_CLIENT:
+        peer = peer_lookup (self,
+                            GUINT32_FROM_LE (ctrl_packet.client.node),
+                            GUINT32_FROM_LE (ctrl_packet.client.port));
+        if (peer)
+            peer_remove (self, peer);
+        break;
+    case QRTR_TYPE_BYE:
+        peers_remove_node (self, GUINT32_FROM_LE (ctrl_packet.client.node));
+        break;
+    default:
+        break;
+    }
+}
+
+static gboolean
+qrtr_request_cb (QrtrServer *self)
+{
+    g_autoptr(QrtrServer) keep_alive = NULL;
+    gint                  n_received;
+    gint                  i;
+
+    if (!self->priv->buffer) {
+        self->priv->buffer = g_malloc (SERVER_BATCH_SIZE * SERVER_BUFFER_SIZE);
+        for (i = 0; i < SERVER_BATCH_SIZE; i++) {
+            self->priv->iovs[i].iov_base = self->priv->buffer + (i * SERVER_BUFFER_SIZE);
+            self->priv->iovs[i].iov_len = SERVER_BUFFER_SIZE;
+            self->priv->msgs[i].msg_hdr.msg_name = &self->priv->addrs[i];
+            self->priv->msgs[i].msg_hdr.msg_iov = &self->priv->iovs[i];
+            self->priv->msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    for (i = 0; i < SERVER_BATCH_SIZE; i++)
+        self->priv->msgs[i].msg_hdr.msg_namelen = sizeof (self->priv->addrs[i]);
+
+    n_received = recvmmsg (g_socket_get_fd (self->priv->socket),
+                           self->priv->msgs, SERVER_BATCH_SIZE, MSG_DONTWAIT, NULL);
+    if (n_received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return TRUE;
+        g_warning ("[qrtr server %u] socket i/o failure: %s", self->priv->service, g_strerror (errno));
+        return FALSE;
+    }
+
+    keep_alive = g_object_ref (self);
+    for (i = 0; i < n_received; i++) {
+        g_autoptr(GBytes)     bytes = NULL;
+        struct mmsghdr       *msg;
+        struct sockaddr_qrtr *addr;
+
+        /* the server may have been disposed by a signal handler */
+        if (!self->priv->watch)
+            break;
+
+        msg = &self->priv->msgs[i];
+        addr = &self->priv->addrs[i];
+        if (msg->msg_hdr.msg_namelen < sizeof (*addr) || addr->sq_family != AF_QIPCRTR)
+            continue;
+        if (msg->msg_hdr.msg_flags & MSG_TRUNC) {
+            g_warning ("[qrtr server %u] discarded truncated message from %u:%u",
+                       self->priv->service, addr->sq_node, addr->sq_port);
+            continue;
+        }
+
+        /* peer removals are notified by the local name service */
+        if (addr->sq_port == QRTR_PORT_CTRL) {
+            if (addr->sq_node == self->priv->node_id)
+                process_ctrl_packet (self, self->priv->iovs[i].iov_base, msg->msg_len);
+            continue;
+        }
+
+        peer_ensure (self, addr->sq_node, addr->sq_port);
+        bytes = g_bytes_new (self->priv->iovs[i].iov_base, msg->msg_len);
+        g_signal_emit (self, signals[SIGNAL_REQUEST], 0, addr->sq_node, addr->sq_port, bytes);
+    }
+
+    return TRUE;
+}
+
+static void
+qrtr_loopback_request_cb (guint32     node_id,
+                          guint32     port,
+                          GBytes     *message,
+                          QrtrServer *self)
+{
+    peer_ensure (self, node_id, port);
+    g_signal_emit (self, signals[SIGNAL_REQUEST], 0, node_id, port, message);
+}
+
+/*****************************************************************************/
+
+static gboolean
+send_server_ctrl_packet (QrtrServer  *self,
+                         guint32      cmd,
+                         GError     **error)
+{
+    struct qrtr_ctrl_pkt ctl_packet;
+    struct sockaddr_qrtr addr;
+
+    fill_peer_address (&addr, self->priv->node_id, QRTR_PORT_CTRL);
+
+    memset (&ctl_packet, 0, sizeof (ctl_packet));
+    ctl_packet.cmd = GUINT32_TO_LE (cmd);
+    ctl_packet.server.service = GUINT32_TO_LE (self->priv->service);
+    ctl_packet.server.instance = GUINT32_TO_LE ((self->priv->instance << 8) | (self->priv->version & 0xff));
+    ctl_packet.server.node = GUINT32_TO_LE (self->priv->node_id);
+    ctl_packet.server.port = GUINT32_TO_LE (self->priv->port);
+
+    if (sendto (g_socket_get_fd (self->priv->socket), (void *)&ctl_packet, sizeof (ctl_packet),
+                0, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+        g_set_error (error,
+                     G_IO_ERROR,
+                     g_io_error_from_errno (errno),
+                     "Failed to send %s control packet: %s",
+                     cmd == QRTR_TYPE_NEW_SERVER ? "server" : "server removal",
+                     g_strerror (errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+initable_init (GInitable    *initable,
+               GCancellable *cancellable,
+               GError      **error)
+{
+    QrtrServer *self = QRTR_SERVER (initable);
+    gint        fd;
+
+    if (g_cancellable_is_cancelled (cancellable)) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+                     "Operation cancelled");
+        return FALSE;
+    }
+
+    fd = socket (AF_QIPCRTR, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Could not create QRTR socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    self->priv->socket = g_socket_new_from_fd (fd, error);
+    if (!self->priv->socket) {
+        g_prefix_error (error, "Could not create QRTR socket: ");
+        close (fd);
+        return FALSE;
+    }
+
+    g_socket_set_timeout (self->priv->socket, 0);
+
+    /* the port needs to be known before publishing the service */
+    if (!qrtr_socket_bind_local (fd, &self->priv->node_id, &self->priv->port, error))
+        return FALSE;
+
+    self->priv->watch = qrtr_reactor_watch_add (g_main_context_get_thread_default (),
+                                                fd,
+                                                G_PRIORITY_DEFAULT,
+                                                (QrtrReactorFunc) qrtr_request_cb,
+                                                self,
+                                                error);
+    if (!self->priv->watch)
+        return FALSE;
+
+    self->priv->loopback = qrtr_loopback_new (self->priv->node_id,
+                                              self->priv->port,
+                                              g_main_context_get_thread_default (),
+                                              G_PRIORITY_DEFAULT,
+                                              SERVER_BATCH_SIZE,
+                                              (QrtrLoopbackFunc) qrtr_loopback_request_cb,
+                                              self);
+
+    if (!send_server_ctrl_packet (self, QRTR_TYPE_NEW_SERVER, error))
+        return FALSE;
+    self->priv->published = TRUE;
+
+    g_debug ("[qrtr server %u] published at %u:%u", self->priv->service, self->priv->node_id, self->priv->port);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+QrtrServer *
+qrtr_server_new (guint32        service,
+                 guint32        version,
+                 guint32        instance,
+                 GCancellable  *cancellable,
+                 GError       **error)
+{
+    return g_initable_new (QRTR_TYPE_SERVER,
+                           cancellable,
+                           error,
+                           QRTR_SERVER_SERVICE,  service,
+                           QRTR_SERVER_VERSION,  version,
+                           QRTR_SERVER_INSTANCE, instance,
+                           NULL);
+}
+
+static void
+qrtr_server_init (QrtrServer *self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
+                                              QRTR_TYPE_SERVER,
+                                              QrtrServerPrivate);
+
+    self->priv->peers = g_hash_table_new_full ((GHashFunc) peer_hash,
+                                               (GEqualFunc) peer_equal,
+                                               (GDestroyNotify) peer_free,
+                                               NULL);
+}
+
+static void
+set_property (GObject      *object,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+    QrtrServer *self = QRTR_SERVER (object);
+
+    switch (prop_id) {
+    case PROP_SERVICE:
+        self->priv->service = (guint32) g_value_get_uint (value);
+        break;
+    case PROP_VERSION:
+        self->priv->version = (guint32) g_value_get_uint (value);
+        break;
+    case PROP_INSTANCE:
+        self->priv->instance = (guint32) g_value_get_uint (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject    *object,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+    QrtrServer *self = QRTR_SERVER (object);
+
+    switch (prop_id) {
+    case PROP_SERVICE:
+        g_value_set_uint (value, (guint) self->priv->service);
+        break;
+    case PROP_VERSION:
+        g_value_set_uint (value, (guint) self->priv->version);
+        break;
+    case PROP_INSTANCE:
+        g_value_set_uint (value, (guint) self->priv->instance);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+dispose (GObject *object)
+{
+    QrtrServer *self = QRTR_SERVER (object);
+
+    g_clear_pointer (&self->priv->watch, qrtr_reactor_watch_remove);
+    g_clear_pointer (&self->priv->loopback, qrtr_loopback_free);
+
+    if (self->priv->socket) {
+        /* the name service would also remove the server once the socket is
+         * closed, but be explicit */
+        if (self->priv->published) {
+            g_autoptr(GError) error = NULL;
+
+            if (!send_server_ctrl_packet (self, QRTR_TYPE_DEL_SERVER, &error))
+                g_debug ("[qrtr server %u] %s", self->priv->service, error->message);
+            self->priv->published = FALSE;
+        }
+        if (!g_socket_is_closed (self->priv->socket))
+            g_socket_close (self->priv->socket, NULL);
+        g_clear_object (&self->priv->socket);
+    }
+
+    g_clear_pointer (&self->priv->peers, g_hash_table_unref);
+    g_clear_pointer (&self->priv->buffer, g_free);
+
+    G_OBJECT_CLASS (qrtr_server_parent_class)->dispose (object);
+}
+
+static void
+initable_iface_init (GInitableIface *iface)
+{
+    iface->init = initable_init;
+}
+
+static void
+qrtr_server_class_init (QrtrServerClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (QrtrServerPrivate));
+
+    object_class->get_property = get_property;
+    object_class->set_property = set_property;
+    object_class->dispose      = dispose;
+
+    /**
+     * QrtrServer:server-service:
+     *
+     * Since: 1.4
+     */
+    properties[PROP_SERVICE] =
+        g_param_spec_uint (QRTR_SERVER_SERVICE,
+                           "service",
+                           "The published QRTR service",
+                           0,
+                           G_MAXUINT32,
+                           0,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_SERVICE, properties[PROP_SERVICE]);
+
+    /**
+     * QrtrServer:server-version:
+     *
+     * Since: 1.4
+     */
+    properties[PROP_VERSION] =
+        g_param_spec_uint (QRTR_SERVER_VERSION,
+                           "version",
+                           "The version of the published QRTR service",
+                           0,
+                           G_MAXUINT8,
+                           0,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_VERSION, properties[PROP_VERSION]);
+
+    /**
+     * QrtrServer:server-instance:
+     *
+     * Since: 1.4
+     */
+    properties[PROP_INSTANCE] =
+        g_param_spec_uint (QRTR_SERVER_INSTANCE,
+                           "instance",
+                           "The instance of the published QRTR service",
+                           0,
+                           G_MAXUINT32 >> 8,
+                           0,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_INSTANCE, properties[PROP_INSTANCE]);
+
+    /**
+     * QrtrServer::server-request
+     * @self: the #QrtrServer
+     * @node_id: the node id of the peer.
+     * @port: the port of the peer.
+     * @message: the message data.
+     *
+     * The ::server-request signal is emitted when a message is received from
+     * a peer.
+     *
+     * Since: 1.4
+     */
+    signals[SIGNAL_REQUEST] =
+        g_signal_new (QRTR_SERVER_SIGNAL_REQUEST,
+                      G_OBJECT_CLASS_TYPE (G_OBJECT_CLASS (klass)),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL,
+                      NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      3,
+                      G_TYPE_UINT,
+                      G_TYPE_UINT,
+                      G_TYPE_BYTES);
+
+    /**
+     * QrtrServer::server-peer-removed
+     * @self: the #QrtrServer
+     * @node_id: the node id of the peer.
+     * @port: the port of the peer.
+     *
+     * The ::server-peer-removed signal is emitted when a peer that sent
+     * messages to the server is gone, either because its port was closed or
+     * because its whole node left the bus.
+     *
+     * The data associated to the peer is freed after the signal is emitted.
+     *
+     * Since: 1.4
+     */
+    signals[SIGNAL_PEER_REMOVED] =
+        g_signal_new (QRTR_SERVER_SIGNAL_PEER_REMOVED,
+                      G_OBJECT_CLASS_TYPE (G_OBJECT_CLASS (klass)),
+                      G_SIGNAL_RUN_LAST,
+                      0,
+                      NULL,
+                      NULL,
+                      NULL,
+                      G_TYPE_NONE,
+                      2,
+                      G_TYPE_UINT,
+                      G_TYPE_UINT);
+}
@@ -0,0 +1,316 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_SERVER_H_
+#define _LIBQRTR_GLIB_QRTR_SERVER_H_
+
+#if !defined (__LIBQRTR_GLIB_H_INSIDE__) && !defined (LIBQRTR_GLIB_COMPILATION)
+#error "Only <libqrtr-glib.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include "qrtr-types.h"
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:qrtr-server
+ * @title: QrtrServer
+ * @short_description: A QRTR service published from userspace.
+ *
+ * The #QrtrServer object publishes a service in the QRTR name service, and
+ * receives the requests sent to it by any number of remote clients, each
+ * identified by its node id and port.
+ *
+ * The server keeps track of the clients (peers) that sent requests, and
+ * reports them as removed when the name service notifies that they are gone,
+ * so that any per-peer state can be released.
+ */
+
+#define QRTR_TYPE_SERVER            (qrtr_server_get_type ())
+#define QRTR_SERVER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), QRTR_TYPE_SERVER, QrtrServer))
+#define QRTR_SERVER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  QRTR_TYPE_SERVER, QrtrServerClass))
+#define QRTR_IS_SERVER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), QRTR_TYPE_SERVER))
+#define QRTR_IS_SERVER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  QRTR_TYPE_SERVER))
+#define QRTR_SERVER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  QRTR_TYPE_SERVER, QrtrServerClass))
+
+typedef struct _QrtrServerClass QrtrServerClass;
+typedef struct _QrtrServerPrivate QrtrServerPrivate;
+
+/**
+ * QRTR_SERVER_SERVICE:
+ *
+ * The service published by this server.
+ *
+ * Since: 1.4
+ */
+#define QRTR_SERVER_SERVICE "server-service"
+
+/**
+ * QRTR_SERVER_VERSION:
+ *
+ * The version of the service published by this server.
+ *
+ * Since: 1.4
+ */
+#define QRTR_SERVER_VERSION "server-version"
+
+/**
+ * QRTR_SERVER_INSTANCE:
+ *
+ * The instance of the service published by this server.
+ *
+ * Since: 1.4
+ */
+#define QRTR_SERVER_INSTANCE "server-instance"
+
+/**
+ * QRTR_SERVER_SIGNAL_REQUEST:
+ *
+ * Symbol defining the #QrtrServer::server-request signal.
+ *
+ * Since: 1.4
+ */
+#define QRTR_SERVER_SIGNAL_REQUEST "server-request"
+
+/**
+ * QRTR_SERVER_SIGNAL_PEER_REMOVED:
+ *
+ * Symbol defining the #QrtrServer::server-peer-removed signal.
+ *
+ * Since: 1.4
+ */
+#define QRTR_SERVER_SIGNAL_PEER_REMOVED "server-peer-removed"
+
+/**
+ * QrtrServer:
+ *
+ * The #QrtrServer structure contains private data and should only be accessed
+ * using the provided API.
+ *
+ * Since: 1.4
+ */
+struct _QrtrServer {
+    /*< private >*/
+    GObject parent;
+    QrtrServerPrivate *priv;
+};
+
+struct _QrtrServerClass {
+    /*< private >*/
+    GObjectClass parent;
+};
+
+GType qrtr_server_get_type (void);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (QrtrServer, g_object_unref)
+
+/**
+ * QrtrServerMessage:
+ * @node_id: the node id of the peer.
+ * @port: the port of the peer.
+ * @message: the message data.
+ *
+ * A message to be sent to a peer with qrtr_server_send_batch().
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    guint32  node_id;
+    guint32  port;
+    GBytes  *message;
+} QrtrServerMessage;
+
+/**
+ * qrtr_server_new:
+ * @service: the service.
+ * @version: the service version.
+ * @instance: the service instance.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @error: Return location for error or %NULL.
+ *
+ * Creates a new #QrtrServer, and publishes the service in the QRTR name
+ * service. The service is removed from the name service when the object is
+ * disposed.
+ *
+ * Returns: (transfer full): a newly allocated #QrtrServer, or %NULL if @error is set.
+ *
+ * Since: 1.4
+ */
+QrtrServer *qrtr_server_new (guint32        service,
+                             guint32        version,
+                             guint32        instance,
+                             GCancellable  *cancellable,
+                             GError       **error);
+
+/**
+ * qrtr_server_get_service:
+ * @self: a #QrtrServer.
+ *
+ * Gets the service published by this server.
+ *
+ * Returns: the service.
+ *
+ * Since: 1.4
+ */
+guint32 qrtr_server_get_service (QrtrServer *self);
+
+/**
+ * qrtr_server_get_version:
+ * @self: a #QrtrServer.
+ *
+ * Gets the version of the service published by this server.
+ *
+ * Returns: the version.
+ *
+ * Since: 1.4
+ */
+guint32 qrtr_server_get_version (QrtrServer *self);
+
+/**
+ * qrtr_server_get_instance:
+ * @self: a #QrtrServer.
+ *
+ * Gets the instance of the service published by this server.
+ *
+ * Returns: the instance.
+ *
+ * Since: 1.4
+ */
+guint32 qrtr_server_get_instance (QrtrServer *self);
+
+/**
+ * qrtr_server_get_node_id:
+ * @self: a #QrtrServer.
+ *
+ * Gets the id of the local node where the service is published.
+ *
+ * Returns: the node id.
+ *
+ * Since: 1.4
+ */
+guint32 qrtr_server_get_node_id (QrtrServer *self);
+
+/**
+ * qrtr_server_get_port:
+ * @self: a #QrtrServer.
+ *
+ * Gets the port where the service is published.
+ *
+ * Returns: the port.
+ *
+ * Since: 1.4
+ */
+guint32 qrtr_server_get_port (QrtrServer *self);
+
+/**
+ * qrtr_server_send:
+ * @self: a #QrtrServer.
+ * @node_id: the node id of the peer.
+ * @port: the port of the peer.
+ * @message: the message.
+ * @error: Return location for #GError or %NULL.
+ *
+ * Sends a message to a peer, e.g. the response to a request.
+ *
+ * The message is sent without blocking; if the peer isn't able to receive it
+ * right away, the %G_IO_ERROR_WOULD_BLOCK error is reported.
+ *
+ * If the peer is another #QrtrServer in this same process, the message is
+ * handed over in memory, without going through the kernel. Messages to
+ * clients always go through the kernel, so that they are filtered and
+ * dispatched as any other message received by the client.
+ *
+ * Returns: %TRUE if the message is sent, or %FALSE if @error is set.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_server_send (QrtrServer  *self,
+                           guint32      node_id,
+                           guint32      port,
+                           GBytes      *message,
+                           GError     **error);
+
+/**
+ * qrtr_server_send_batch:
+ * @self: a #QrtrServer.
+ * @messages: (array length=n_messages): the messages to send.
+ * @n_messages: the number of messages in @messages.
+ * @error: Return location for #GError or %NULL.
+ *
+ * Sends multiple messages, possibly to different peers, with as few system
+ * calls as possible.
+ *
+ * Messages to the same peer are sent in order, and sending stops at the
+ * first message that cannot be sent.
+ *
+ * Returns: the number of messages sent, which is less than @n_messages if
+ *  @error is set.
+ *
+ * Since: 1.4
+ */
+guint qrtr_server_send_batch (QrtrServer               *self,
+                              const QrtrServerMessage  *messages,
+                              guint                     n_messages,
+                              GError                  **error);
+
+/**
+ * qrtr_server_get_n_peers:
+ * @self: a #QrtrServer.
+ *
+ * Gets the number of peers known by the server.
+ *
+ * Returns: the number of peers.
+ *
+ * Since: 1.4
+ */
+guint qrtr_server_get_n_peers (QrtrServer *self);
+
+/**
+ * qrtr_server_set_peer_data:
+ * @self: a #QrtrServer.
+ * @node_id: the node id of the peer.
+ * @port: the port of the peer.
+ * @data: (nullable): the data to associate to the peer.
+ * @destroy: (nullable): the function to free @data, or %NULL.
+ *
+ * Associates user data to a peer that has sent requests to the server,
+ * replacing (and freeing) any previous one.
+ *
+ * The data is freed when the peer is removed, or when the server is disposed.
+ *
+ * Returns: %TRUE if the data is set, or %FALSE if the peer is unknown.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_server_set_peer_data (QrtrServer     *self,
+                                    guint32         node_id,
+                                    guint32         port,
+                                    gpointer        data,
+                                    GDestroyNotify  destroy);
+
+/**
+ * qrtr_server_get_peer_data:
+ * @self: a #QrtrServer.
+ * @node_id: the node id of the peer.
+ * @port: the port of the peer.
+ *
+ * Gets the user data associated to a peer with qrtr_server_set_peer_data().
+ *
+ * Returns: (transfer none) (nullable): the data, or %NULL if none.
+ *
+ * Since: 1.4
+ */
+gpointer qrtr_server_get_peer_data (QrtrServer *self,
+                                    guint32     node_id,
+                                    guint32     port);
+
+G_END_DECLS
+
+#endif /* _LIBQRTR_GLIB_QRTR_SERVER_H_ */
@@ -0,0 +1,227 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <string.h>
+
+#include <gio/gio.h>
+
+#include "qrtr-node.h"
+#include "qrtr-service-table.h"
+#include "qrtr-utils.h"
+
+/* rows are scanned in blocks, with the per-row matches kept in a small
+ * array so that the comparisons don't branch */
+#define QUERY_BLOCK_SIZE 64
+
+/* the hash table value; it's the key holder too, so that the row can be
+ * updated in place when rows are moved */
+typedef struct {
+    guint64 key;
+    guint   row;
+} RowRef;
+
+struct _QrtrServiceTable {
+    guint     n_rows;
+    guint     n_allocated;
+    guint32  *node_ids;
+    guint32  *services;
+    guint32  *ports;
+    guint32  *versions;
+    guint32  *instances;
+    RowRef  **refs;
+    /* (node id, port) -> RowRef */
+    GHashTable *index;
+};
+
+static void
+row_ref_free (RowRef *ref)
+{
+    g_slice_free (RowRef, ref);
+}
+
+static void
+row_get_record (QrtrServiceTable     *self,
+                guint                 row,
+                QrtrBusServiceRecord *record)
+{
+    record->node_id = self->node_ids[row];
+    record->service = self->services[row];
+    record->port = self->ports[row];
+    record->version = self->versions[row];
+    record->instance = self->instances[row];
+}
+
+/*****************************************************************************/
+
+QrtrServiceTable *
+qrtr_service_table_new (void)
+{
+    QrtrServiceTable *self;
+
+    self = g_slice_new0 (QrtrServiceTable);
+    self->index = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, (GDestroyNotify)row_ref_free);
+    return self;
+}
+
+void
+qrtr_service_table_free (QrtrServiceTable *self)
+{
+    g_hash_table_unref (self->index);
+    g_free (self->node_ids);
+    g_free (self->services);
+    g_free (self->ports);
+    g_free (self->versions);
+    g_free (self->instances);
+    g_free (self->refs);
+    g_slice_free (QrtrServiceTable, self);
+}
+
+static void
+table_grow (QrtrServiceTable *self)
+{
+    self->n_allocated = MAX (16, self->n_allocated * 2);
+    self->node_ids  = g_renew (guint32, self->node_ids,  self->n_allocated);
+    self->services  = g_renew (guint32, self->services,  self->n_allocated);
+    self->ports     = g_renew (guint32, self->ports,     self->n_allocated);
+    self->versions  = g_renew (guint32, self->versions,  self->n_allocated);
+    self->instances = g_renew (guint32, self->instances, self->n_allocated);
+    self->refs      = g_renew (RowRef *, self->refs,     self->n_allocated);
+}
+
+gboolean
+qrtr_service_table_upsert (QrtrServiceTable     *self,
+                           guint32               node_id,
+                           guint32               port,
+                           guint32               service,
+                           guint32               version,
+                           guint32               instance,
+                           QrtrBusServiceRecord *previous)
+{
+    RowRef   *ref;
+    guint64   key;
+    gboolean  existed;
+
+    key = qrtr_address_key (node_id, port);
+    ref = g_hash_table_lookup (self->index, &key);
+    existed = !!ref;
+    if (existed)
+        row_get_record (self, ref->row, previous);
+    else {
+        if (self->n_rows == self->n_allocated)
+            table_grow (self);
+
+        ref = g_slice_new (RowRef);
+        ref->key = key;
+        ref->row = self->n_rows++;
+        g_hash_table_insert (self->index, &ref->key, ref);
+
+        self->node_ids[ref->row] = node_id;
+        self->ports[ref->row] = port;
+        self->refs[ref->row] = ref;
+    }
+
+    self->services[ref->row] = service;
+    self->versions[ref->row] = version;
+    self->instances[ref->row] = instance;
+    return existed;
+}
+
+gboolean
+qrtr_service_table_remove (QrtrServiceTable     *self,
+                           guint32               node_id,
+                           guint32               port,
+                           QrtrBusServiceRecord *removed)
+{
+    RowRef *ref;
+    guint64 key;
+    guint   row;
+    guint   last;
+
+    key = qrtr_address_key (node_id, port);
+    ref = g_hash_table_lookup (self->index, &key);
+    if (!ref)
+        return FALSE;
+
+    /* move the last row to the removed position */
+    row = ref->row;
+    row_get_record (self, row, removed);
+    last = --self->n_rows;
+    if (row != last) {
+        self->node_ids[row]  = self->node_ids[last];
+        self->services[row]  = self->services[last];
+        self->ports[row]     = self->ports[last];
+        self->versions[row]  = self->versions[last];
+        self->instances[row] = self->instances[last];
+        self->refs[row]      = self->refs[last];
+        self->refs[row]->row = row;
+    }
+
+    g_hash_table_remove (self->index, &key);
+    return TRUE;
+}
+
+guint
+qrtr_service_table_query (QrtrServiceTable           *self,
+                          const QrtrBusServiceFilter *filter,
+                          GArray                     *results)
+{
+    guint8   any_node;
+    guint8   any_instance;
+    guint    n_results = 0;
+    guint    base;
+
+    any_node = (filter->node_id == QRTR_BUS_NODE_ID_ANY);
+    any_instance = (filter->instance == QRTR_NODE_INSTANCE_ANY);
+
+    for (base = 0; base < self->n_rows; base += QUERY_BLOCK_SIZE) {
+        guint8         match[QUERY_BLOCK_SIZE];
+        const guint32 *node_ids  = self->node_ids + base;
+        const guint32 *services  = self->services + base;
+        const guint32 *versions  = self->versions + base;
+        const guint32 *instances = self->instances + base;
+        guint          len;
+        guint          i;
+
+        len = MIN (QUERY_BLOCK_SIZE, self->n_rows - base);
+
+        for (i = 0; i < len; i++)
+            match[i] = (guint8) ((any_node | (node_ids[i] == filter->node_id)) &
+                                 (versions[i] >= filter->min_version) &
+                                 (versions[i] <= filter->max_version) &
+                                 (any_instance | (instances[i] == filter->instance)));
+
+        if (filter->services) {
+            guint8 in_set[QUERY_BLOCK_SIZE];
+            guint  j;
+
+            /* one pass over the block per service in the set */
+            memset (in_set, 0, len);
+            for (j = 0; j < filter->n_services; j++) {
+                guint32 service = filter->services[j];
+
+                for (i = 0; i < len; i++)
+                    in_set[i] |= (guint8) (services[i] == service);
+            }
+            for (i = 0; i < len; i++)
+                match[i] &= in_set[i];
+        }
+
+        for (i = 0; i < len; i++) {
+            QrtrBusServiceRecord record;
+
+            if (!match[i])
+                continue;
+
+            row_get_record (self, base + i, &record);
+            g_array_append_val (results, record);
+            n_results++;
+        }
+    }
+
+    return n_results;
+}
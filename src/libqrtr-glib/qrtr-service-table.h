@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_SERVICE_TABLE_H_
+#define _LIBQRTR_GLIB_QRTR_SERVICE_TABLE_H_
+
+#if !defined (LIBQRTR_GLIB_COMPILATION)
+#error "This is a private header."
+#endif
+
+#include <glib.h>
+
+#include "qrtr-bus.h"
+
+/*
+ * The service table keeps all the servers known in the bus as a structure of
+ * arrays, one column per field, so that queries are linear scans over
+ * contiguous memory which the compiler can vectorize. Servers are keyed by
+ * node id and port; rows are unordered, as removals move the last row to the
+ * removed position.
+ */
+
+typedef struct _QrtrServiceTable QrtrServiceTable;
+
+G_GNUC_INTERNAL
+QrtrServiceTable *qrtr_service_table_new (void);
+
+G_GNUC_INTERNAL
+void qrtr_service_table_free (QrtrServiceTable *self);
+
+/* Returns TRUE if there was already a server in the port, which is then
+ * given in previous */
+G_GNUC_INTERNAL
+gboolean qrtr_service_table_upsert (QrtrServiceTable     *self,
+                                    guint32               node_id,
+                                    guint32               port,
+                                    guint32               service,
+                                    guint32               version,
+                                    guint32               instance,
+                                    QrtrBusServiceRecord *previous);
+
+G_GNUC_INTERNAL
+gboolean qrtr_service_table_remove (QrtrServiceTable     *self,
+                                    guint32               node_id,
+                                    guint32               port,
+                                    QrtrBusServiceRecord *removed);
+
+G_GNUC_INTERNAL
+guint qrtr_service_table_query (QrtrServiceTable           *self,
+                                const QrtrBusServiceFilter *filter,
+                                GArray                     *results);
+
+#endif /* _LIBQRTR_GLIB_QRTR_SERVICE_TABLE_H_ */
@@ -0,0 +1,505 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <gio/gio.h>
+
+#include "qrtr-server.h"
+#include "qrtr-traffic.h"
+#include "qrtr-utils.h"
+
+/* "QTRF", in the first 4 bytes of every message */
+#define TRAFFIC_MAGIC 0x46525451
+/* interval of the timer sending indications */
+#define TRAFFIC_TICK_MS 1
+/* max number of indications sent to a peer in a single tick */
+#define TRAFFIC_TICK_MAX_MESSAGES 256
+
+G_STATIC_ASSERT ((gint) QRTR_TRAFFIC_RATE_MAX / 1000 * TRAFFIC_TICK_MS <= TRAFFIC_TICK_MAX_MESSAGES);
+
+/* header of every message, in little endian */
+typedef struct {
+    guint32 magic;
+    guint32 sequence;
+    gint64  timestamp;
+} __attribute__((packed)) TrafficHeader;
+
+G_STATIC_ASSERT (sizeof (TrafficHeader) == QRTR_TRAFFIC_MESSAGE_MIN_SIZE);
+
+G_DEFINE_TYPE (QrtrTrafficGenerator, qrtr_traffic_generator, G_TYPE_OBJECT)
+
+enum {
+    PROP_0,
+    PROP_SERVER,
+    PROP_LAST
+};
+
+static GParamSpec *properties[PROP_LAST];
+
+/* a peer receiving indications */
+typedef struct {
+    guint64 key;
+    guint32 node_id;
+    guint32 port;
+    guint32 sequence;
+    /* in fractional microseconds, so that the rounding errors of the
+     * intervals don't build up */
+    gdouble next_time;
+} Peer;
+
+struct _QrtrTrafficGeneratorPrivate {
+    QrtrServer        *server;
+    gulong             request_id;
+    gulong             peer_removed_id;
+    QrtrTrafficConfig  config;
+    GRand             *rand;
+
+    /* (node id, port) -> Peer */
+    GHashTable *peers;
+    GSource    *tick_source;
+
+    guint64 n_sent;
+    guint64 n_failed;
+};
+
+static void
+peer_free (Peer *peer)
+{
+    g_slice_free (Peer, peer);
+}
+
+/*****************************************************************************/
+
+static gdouble
+exponential (GRand   *rand,
+             gdouble  mean)
+{
+    /* 1 - [0,1) is never 0 */
+    return -log (1.0 - g_rand_double (rand)) * mean;
+}
+
+gsize
+qrtr_traffic_config_next_size (const QrtrTrafficConfig *config,
+                               GRand                   *rand)
+{
+    gsize min_size;
+    gsize max_size;
+    gsize size;
+
+    g_return_val_if_fail (config, 0);
+    g_return_val_if_fail (rand, 0);
+
+    min_size = CLAMP (config->min_size, QRTR_TRAFFIC_MESSAGE_MIN_SIZE, QRTR_TRAFFIC_MESSAGE_MAX_SIZE);
+    max_size = CLAMP (config->max_size, min_size, QRTR_TRAFFIC_MESSAGE_MAX_SIZE);
+
+    switch (config->size_distribution) {
+    case QRTR_TRAFFIC_DISTRIBUTION_UNIFORM:
+        size = min_size + (gsize) g_rand_int_range (rand, 0, (gint32) (max_size - min_size + 1));
+        break;
+    case QRTR_TRAFFIC_DISTRIBUTION_EXPONENTIAL:
+        size = min_size + (gsize) MIN (exponential (rand, (max_size - min_size) / 2.0),
+                                       (gdouble) (max_size - min_size));
+        break;
+    case QRTR_TRAFFIC_DISTRIBUTION_FIXED:
+    default:
+        size = min_size;
+        break;
+    }
+
+    return size;
+}
+
+gdouble
+qrtr_traffic_config_next_interval (const QrtrTrafficConfig *config,
+                                   GRand                   *rand)
+{
+    gdouble mean;
+
+    g_return_val_if_fail (config, 0.0);
+    g_return_val_if_fail (rand, 0.0);
+
+    if (config->rate <= 0.0)
+        return G_MAXDOUBLE;
+
+    mean = G_USEC_PER_SEC / MIN (config->rate, QRTR_TRAFFIC_RATE_MAX);
+    switch (config->interval_distribution) {
+    case QRTR_TRAFFIC_DISTRIBUTION_UNIFORM:
+        return g_rand_double_range (rand, 0.0, 2.0 * mean);
+    case QRTR_TRAFFIC_DISTRIBUTION_EXPONENTIAL:
+        return exponential (rand, mean);
+    case QRTR_TRAFFIC_DISTRIBUTION_FIXED:
+    default:
+        return mean;
+    }
+}
+
+GBytes *
+qrtr_traffic_message_new (guint32 sequence,
+                          gsize   size)
+{
+    TrafficHeader *header;
+    guint8        *data;
+
+    size = CLAMP (size, QRTR_TRAFFIC_MESSAGE_MIN_SIZE, QRTR_TRAFFIC_MESSAGE_MAX_SIZE);
+
+    /* the payload is not initialized on purpose, it's never looked at */
+    data = g_malloc (size);
+    header = (TrafficHeader *) data;
+    header->magic = GUINT32_TO_LE (TRAFFIC_MAGIC);
+    header->sequence = GUINT32_TO_LE (sequence);
+    header->timestamp = GINT64_TO_LE (g_get_monotonic_time ());
+    return g_bytes_new_take (data, size);
+}
+
+gboolean
+qrtr_traffic_stats_add_message (QrtrTrafficStats *stats,
+                                GBytes           *message)
+{
+    TrafficHeader header;
+    const guint8 *data;
+    gsize         size;
+    guint32       sequence;
+    gint64        now;
+    gint64        latency;
+
+    g_return_val_if_fail (stats, FALSE);
+    g_return_val_if_fail (message, FALSE);
+
+    data = g_bytes_get_data (message, &size);
+    if (size < sizeof (header))
+        return FALSE;
+
+    memcpy (&header, data, sizeof (header));
+    if (GUINT32_FROM_LE (header.magic) != TRAFFIC_MAGIC)
+        return FALSE;
+
+    now = g_get_monotonic_time ();
+    if (!stats->n_messages)
+        stats->first_time = now;
+    stats->last_time = now;
+    stats->n_messages++;
+    stats->n_bytes += size;
+
+    latency = MAX (0, now - GINT64_FROM_LE (header.timestamp));
+    stats->total_latency += latency;
+    stats->max_latency = MAX (stats->max_latency, latency);
+
+    /* wrap-around safe comparison of the sequence numbers */
+    sequence = GUINT32_FROM_LE (header.sequence);
+    if ((gint32) (sequence - stats->next_sequence) >= 0) {
+        stats->n_lost += sequence - stats->next_sequence;
+        stats->next_sequence = sequence + 1;
+    } else {
+        /* a message already accounted as lost arrived late, or a duplicate */
+        if (stats->n_lost)
+            stats->n_lost--;
+        stats->n_late++;
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+peer_send_indications (QrtrTrafficGenerator *self,
+                       Peer                 *peer,
+                       gint64                now)
+{
+    QrtrServerMessage  messages[TRAFFIC_TICK_MAX_MESSAGES];
+    g_autoptr(GError)  error = NULL;
+    guint              n_messages = 0;
+    guint              n_sent;
+    guint              i;
+
+    while (peer->next_time <= now && n_messages < TRAFFIC_TICK_MAX_MESSAGES) {
+        messages[n_messages].node_id = peer->node_id;
+        messages[n_messages].port = peer->port;
+        messages[n_messages].message = qrtr_traffic_message_new (peer->sequence + n_messages,
+                                                                 qrtr_traffic_config_next_size (&self->priv->config,
+                                                                                                self->priv->rand));
+        n_messages++;
+
+        /* never overflows, G_MAXDOUBLE absorbs the current time */
+        peer->next_time += qrtr_traffic_config_next_interval (&self->priv->config, self->priv->rand);
+    }
+
+    if (!n_messages)
+        return;
+
+    n_sent = qrtr_server_send_batch (self->priv->server, messages, n_messages, &error);
+    if (n_sent < n_messages)
+        g_debug ("[qrtr traffic] couldn't send %u indications to %u:%u: %s",
+                 n_messages - n_sent, peer->node_id, peer->port, error->message);
+
+    /* messages not sent are given up, and their sequence numbers reused */
+    peer->sequence += n_sent;
+    self->priv->n_sent += n_sent;
+    self->priv->n_failed += n_messages - n_sent;
+
+    for (i = 0; i < n_messages; i++)
+        g_bytes_unref (messages[i].message);
+}
+
+static gboolean
+tick_cb (QrtrTrafficGenerator *self)
+{
+    GHashTableIter  iter;
+    Peer           *peer;
+    gint64          now;
+
+    now = g_get_monotonic_time ();
+    g_hash_table_iter_init (&iter, self->priv->peers);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&peer))
+        peer_send_indications (self, peer, now);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+tick_source_update (QrtrTrafficGenerator *self)
+{
+    if (!g_hash_table_size (self->priv->peers)) {
+        if (self->priv->tick_source) {
+            g_source_destroy (self->priv->tick_source);
+            g_clear_pointer (&self->priv->tick_source, g_source_unref);
+        }
+        return;
+    }
+
+    if (self->priv->tick_source)
+        return;
+
+    self->priv->tick_source = g_timeout_source_new (TRAFFIC_TICK_MS);
+    g_source_set_callback (self->priv->tick_source, (GSourceFunc) tick_cb, self, NULL);
+    g_source_attach (self->priv->tick_source, g_main_context_get_thread_default ());
+}
+
+static void
+server_request_cb (QrtrServer           *server,
+                   guint                 node_id,
+                   guint                 port,
+                   GBytes               *message,
+                   QrtrTrafficGenerator *self)
+{
+    Peer   *peer;
+    guint64 key;
+
+    if (self->priv->config.mode == QRTR_TRAFFIC_MODE_ECHO) {
+        g_autoptr(GError) error = NULL;
+
+        if (qrtr_server_send (server, node_id, port, message, &error))
+            self->priv->n_sent++;
+        else {
+            g_debug ("[qrtr traffic] couldn't echo request to %u:%u: %s", node_id, port, error->message);
+            self->priv->n_failed++;
+        }
+        return;
+    }
+
+    /* any request subscribes the peer to the indications */
+    key = qrtr_address_key (node_id, port);
+    if (g_hash_table_contains (self->priv->peers, &key))
+        return;
+
+    peer = g_slice_new0 (Peer);
+    peer->key = key;
+    peer->node_id = node_id;
+    peer->port = port;
+    peer->next_time = (gdouble) g_get_monotonic_time ();
+    g_hash_table_insert (self->priv->peers, &peer->key, peer);
+    g_debug ("[qrtr traffic] sending indications to %u:%u", node_id, port);
+    tick_source_update (self);
+}
+
+static void
+server_peer_removed_cb (QrtrServer           *server,
+                        guint                 node_id,
+                        guint                 port,
+                        QrtrTrafficGenerator *self)
+{
+    guint64 key;
+
+    key = qrtr_address_key (node_id, port);
+    if (!g_hash_table_remove (self->priv->peers, &key))
+        return;
+
+    g_debug ("[qrtr traffic] peer %u:%u removed", node_id, port);
+    tick_source_update (self);
+}
+
+/*****************************************************************************/
+
+QrtrServer *
+qrtr_traffic_generator_peek_server (QrtrTrafficGenerator *self)
+{
+    g_return_val_if_fail (QRTR_IS_TRAFFIC_GENERATOR (self), NULL);
+
+    return self->priv->server;
+}
+
+guint64
+qrtr_traffic_generator_get_n_sent (QrtrTrafficGenerator *self)
+{
+    g_return_val_if_fail (QRTR_IS_TRAFFIC_GENERATOR (self), 0);
+
+    return self->priv->n_sent;
+}
+
+guint64
+qrtr_traffic_generator_get_n_failed (QrtrTrafficGenerator *self)
+{
+    g_return_val_if_fail (QRTR_IS_TRAFFIC_GENERATOR (self), 0);
+
+    return self->priv->n_failed;
+}
+
+QrtrTrafficGenerator *
+qrtr_traffic_generator_new (QrtrServer              *server,
+                            const QrtrTrafficConfig *config)
+{
+    QrtrTrafficGenerator *self;
+
+    g_return_val_if_fail (QRTR_IS_SERVER (server), NULL);
+    g_return_val_if_fail (config, NULL);
+
+    self = g_object_new (QRTR_TYPE_TRAFFIC_GENERATOR,
+                         QRTR_TRAFFIC_GENERATOR_SERVER, server,
+                         NULL);
+    self->priv->config = *config;
+    return self;
+}
+
+/*****************************************************************************/
+
+static void
+qrtr_traffic_generator_init (QrtrTrafficGenerator *self)
+{
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
+                                              QRTR_TYPE_TRAFFIC_GENERATOR,
+                                              QrtrTrafficGeneratorPrivate);
+
+    self->priv->rand = g_rand_new ();
+    self->priv->peers = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, (GDestroyNotify)peer_free);
+}
+
+static void
+constructed (GObject *object)
+{
+    QrtrTrafficGenerator *self = QRTR_TRAFFIC_GENERATOR (object);
+
+    G_OBJECT_CLASS (qrtr_traffic_generator_parent_class)->constructed (object);
+
+    g_assert (self->priv->server);
+    self->priv->request_id =
+        g_signal_connect (self->priv->server,
+                          QRTR_SERVER_SIGNAL_REQUEST,
+                          G_CALLBACK (server_request_cb),
+                          self);
+    self->priv->peer_removed_id =
+        g_signal_connect (self->priv->server,
+                          QRTR_SERVER_SIGNAL_PEER_REMOVED,
+                          G_CALLBACK (server_peer_removed_cb),
+                          self);
+}
+
+static void
+set_property (GObject      *object,
+              guint         prop_id,
+              const GValue *value,
+              GParamSpec   *pspec)
+{
+    QrtrTrafficGenerator *self = QRTR_TRAFFIC_GENERATOR (object);
+
+    switch (prop_id) {
+    case PROP_SERVER:
+        g_assert (!self->priv->server);
+        self->priv->server = g_value_dup_object (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject    *object,
+              guint       prop_id,
+              GValue     *value,
+              GParamSpec *pspec)
+{
+    QrtrTrafficGenerator *self = QRTR_TRAFFIC_GENERATOR (object);
+
+    switch (prop_id) {
+    case PROP_SERVER:
+        g_value_set_object (value, self->priv->server);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+dispose (GObject *object)
+{
+    QrtrTrafficGenerator *self = QRTR_TRAFFIC_GENERATOR (object);
+
+    if (self->priv->server) {
+        g_signal_handler_disconnect (self->priv->server, self->priv->request_id);
+        g_signal_handler_disconnect (self->priv->server, self->priv->peer_removed_id);
+        g_clear_object (&self->priv->server);
+    }
+
+    if (self->priv->peers) {
+        g_hash_table_remove_all (self->priv->peers);
+        tick_source_update (self);
+    }
+
+    G_OBJECT_CLASS (qrtr_traffic_generator_parent_class)->dispose (object);
+}
+
+static void
+finalize (GObject *object)
+{
+    QrtrTrafficGenerator *self = QRTR_TRAFFIC_GENERATOR (object);
+
+    g_hash_table_unref (self->priv->peers);
+    g_rand_free (self->priv->rand);
+
+    G_OBJECT_CLASS (qrtr_traffic_generator_parent_class)->finalize (object);
+}
+
+static void
+qrtr_traffic_generator_class_init (QrtrTrafficGeneratorClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (QrtrTrafficGeneratorPrivate));
+
+    object_class->constructed  = constructed;
+    object_class->get_property = get_property;
+    object_class->set_property = set_property;
+    object_class->dispose      = dispose;
+    object_class->finalize     = finalize;
+
+    /**
+     * QrtrTrafficGenerator:traffic-generator-server:
+     *
+     * Since: 1.4
+     */
+    properties[PROP_SERVER] =
+        g_param_spec_object (QRTR_TRAFFIC_GENERATOR_SERVER,
+                             "server",
+                             "The server where traffic is generated",
+                             QRTR_TYPE_SERVER,
+                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_SERVER, properties[PROP_SERVER]);
+}
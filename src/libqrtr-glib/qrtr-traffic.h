@@ -0,0 +1,327 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _LIBQRTR_GLIB_QRTR_TRAFFIC_H_
+#define _LIBQRTR_GLIB_QRTR_TRAFFIC_H_
+
+#if !defined (__LIBQRTR_GLIB_H_INSIDE__) && !defined (LIBQRTR_GLIB_COMPILATION)
+#error "Only <libqrtr-glib.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+#include "qrtr-types.h"
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:qrtr-traffic
+ * @title: QrtrTrafficGenerator
+ * @short_description: Synthetic traffic for datapath load tests.
+ *
+ * The #QrtrTrafficGenerator object drives synthetic traffic on a #QrtrServer,
+ * so that the datapath of clients can be benchmarked without real remote
+ * services. The generator either echoes every request back to its sender,
+ * or sends indications to every peer that sent a request, at a given rate
+ * and with given message size and interval distributions.
+ *
+ * Every generated message starts with a header carrying a sequence number
+ * and a timestamp, so that the receiving side can account for throughput,
+ * lost messages and latency with a #QrtrTrafficStats. The timestamps are
+ * taken from the monotonic clock, so latencies are only meaningful when
+ * both sides run in the same system, e.g. on the local node.
+ */
+
+#define QRTR_TYPE_TRAFFIC_GENERATOR            (qrtr_traffic_generator_get_type ())
+#define QRTR_TRAFFIC_GENERATOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), QRTR_TYPE_TRAFFIC_GENERATOR, QrtrTrafficGenerator))
+#define QRTR_TRAFFIC_GENERATOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  QRTR_TYPE_TRAFFIC_GENERATOR, QrtrTrafficGeneratorClass))
+#define QRTR_IS_TRAFFIC_GENERATOR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), QRTR_TYPE_TRAFFIC_GENERATOR))
+#define QRTR_IS_TRAFFIC_GENERATOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  QRTR_TYPE_TRAFFIC_GENERATOR))
+#define QRTR_TRAFFIC_GENERATOR_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  QRTR_TYPE_TRAFFIC_GENERATOR, QrtrTrafficGeneratorClass))
+
+typedef struct _QrtrTrafficGeneratorClass QrtrTrafficGeneratorClass;
+typedef struct _QrtrTrafficGeneratorPrivate QrtrTrafficGeneratorPrivate;
+
+/**
+ * QRTR_TRAFFIC_GENERATOR_SERVER:
+ *
+ * The server where traffic is generated.
+ *
+ * Since: 1.4
+ */
+#define QRTR_TRAFFIC_GENERATOR_SERVER "traffic-generator-server"
+
+/**
+ * QRTR_TRAFFIC_MESSAGE_MIN_SIZE:
+ *
+ * The size of the header of the generated messages, and so the minimum size
+ * of a message.
+ *
+ * Since: 1.4
+ */
+#define QRTR_TRAFFIC_MESSAGE_MIN_SIZE 16
+
+/**
+ * QRTR_TRAFFIC_MESSAGE_MAX_SIZE:
+ *
+ * The maximum size of a generated message.
+ *
+ * Since: 1.4
+ */
+#define QRTR_TRAFFIC_MESSAGE_MAX_SIZE (64 * 1024)
+
+/**
+ * QRTR_TRAFFIC_RATE_MAX:
+ *
+ * The maximum rate of generated messages per second, to each peer. Messages
+ * are sent from a 1 ms timer, at most 256 of them in each run; higher rates
+ * are clamped to this value.
+ *
+ * Since: 1.4
+ */
+#define QRTR_TRAFFIC_RATE_MAX 256000.0
+
+/**
+ * QrtrTrafficGenerator:
+ *
+ * The #QrtrTrafficGenerator structure contains private data and should only be
+ * accessed using the provided API.
+ *
+ * Since: 1.4
+ */
+struct _QrtrTrafficGenerator {
+    /*< private >*/
+    GObject parent;
+    QrtrTrafficGeneratorPrivate *priv;
+};
+
+struct _QrtrTrafficGeneratorClass {
+    /*< private >*/
+    GObjectClass parent;
+};
+
+GType qrtr_traffic_generator_get_type (void);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (QrtrTrafficGenerator, g_object_unref)
+
+/**
+ * QrtrTrafficMode:
+ * @QRTR_TRAFFIC_MODE_ECHO: every request is sent back to its sender.
+ * @QRTR_TRAFFIC_MODE_INDICATIONS: indications are sent to every peer that
+ *  sent a request, until the peer is removed.
+ *
+ * The traffic generated by a #QrtrTrafficGenerator.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+    QRTR_TRAFFIC_MODE_ECHO,
+    QRTR_TRAFFIC_MODE_INDICATIONS
+} QrtrTrafficMode;
+
+/**
+ * QrtrTrafficDistribution:
+ * @QRTR_TRAFFIC_DISTRIBUTION_FIXED: always the same value.
+ * @QRTR_TRAFFIC_DISTRIBUTION_UNIFORM: uniformly distributed values.
+ * @QRTR_TRAFFIC_DISTRIBUTION_EXPONENTIAL: exponentially distributed values,
+ *  e.g. the intervals of a Poisson process.
+ *
+ * The distribution of the message sizes and intervals.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+    QRTR_TRAFFIC_DISTRIBUTION_FIXED,
+    QRTR_TRAFFIC_DISTRIBUTION_UNIFORM,
+    QRTR_TRAFFIC_DISTRIBUTION_EXPONENTIAL
+} QrtrTrafficDistribution;
+
+/**
+ * QrtrTrafficConfig:
+ * @mode: the traffic to generate.
+ * @rate: the mean number of messages per second sent to each peer, up to
+ *  %QRTR_TRAFFIC_RATE_MAX.
+ * @interval_distribution: the distribution of the intervals between
+ *  messages: fixed at 1/@rate, uniform between 0 and 2/@rate, or
+ *  exponential with mean 1/@rate.
+ * @size_distribution: the distribution of the message sizes: fixed at
+ *  @min_size, uniform between @min_size and @max_size, or @min_size plus an
+ *  exponential with mean (@max_size - @min_size) / 2, truncated at @max_size.
+ * @min_size: the minimum size of the messages.
+ * @max_size: the maximum size of the messages.
+ *
+ * The configuration of the generated traffic. Sizes are always within
+ * %QRTR_TRAFFIC_MESSAGE_MIN_SIZE and %QRTR_TRAFFIC_MESSAGE_MAX_SIZE. In
+ * %QRTR_TRAFFIC_MODE_ECHO mode, only @mode is used.
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    QrtrTrafficMode          mode;
+    gdouble                  rate;
+    QrtrTrafficDistribution  interval_distribution;
+    QrtrTrafficDistribution  size_distribution;
+    gsize                    min_size;
+    gsize                    max_size;
+} QrtrTrafficConfig;
+
+/**
+ * QrtrTrafficStats:
+ * @n_messages: the number of messages received.
+ * @n_bytes: the number of bytes received.
+ * @n_lost: the number of messages not received, as per the gaps in the
+ *  sequence numbers.
+ * @n_late: the number of messages received out of order or duplicated.
+ * @next_sequence: the sequence number of the next message expected.
+ * @first_time: the monotonic time when the first message was received.
+ * @last_time: the monotonic time when the last message was received.
+ * @total_latency: the sum of the latencies of all messages, in microseconds.
+ * @max_latency: the maximum latency of a message, in microseconds.
+ *
+ * Statistics of the traffic received from a #QrtrTrafficGenerator, or from a
+ * peer sending messages built with qrtr_traffic_message_new(). The structure
+ * must be zero-initialized before use.
+ *
+ * Since: 1.4
+ */
+typedef struct {
+    guint64 n_messages;
+    guint64 n_bytes;
+    guint64 n_lost;
+    guint64 n_late;
+    guint32 next_sequence;
+    gint64  first_time;
+    gint64  last_time;
+    gint64  total_latency;
+    gint64  max_latency;
+} QrtrTrafficStats;
+
+/**
+ * qrtr_traffic_generator_new:
+ * @server: a #QrtrServer.
+ * @config: a #QrtrTrafficConfig.
+ *
+ * Creates a new #QrtrTrafficGenerator generating traffic on @server. The
+ * server must be used in the thread-default main context where it was
+ * created.
+ *
+ * Returns: (transfer full): a newly allocated #QrtrTrafficGenerator.
+ *
+ * Since: 1.4
+ */
+QrtrTrafficGenerator *qrtr_traffic_generator_new (QrtrServer              *server,
+                                                  const QrtrTrafficConfig *config);
+
+/**
+ * qrtr_traffic_generator_peek_server:
+ * @self: a #QrtrTrafficGenerator.
+ *
+ * Get the #QrtrServer where the traffic is generated.
+ *
+ * Returns: (transfer none): a #QrtrServer.
+ *
+ * Since: 1.4
+ */
+QrtrServer *qrtr_traffic_generator_peek_server (QrtrTrafficGenerator *self);
+
+/**
+ * qrtr_traffic_generator_get_n_sent:
+ * @self: a #QrtrTrafficGenerator.
+ *
+ * Gets the number of messages sent so far.
+ *
+ * Returns: the number of messages.
+ *
+ * Since: 1.4
+ */
+guint64 qrtr_traffic_generator_get_n_sent (QrtrTrafficGenerator *self);
+
+/**
+ * qrtr_traffic_generator_get_n_failed:
+ * @self: a #QrtrTrafficGenerator.
+ *
+ * Gets the number of messages that couldn't be sent so far, e.g. because
+ * the receive queue of the peer was full. These messages are not retried,
+ * and they don't take a sequence number, so they are not reported as lost
+ * by the receiving side.
+ *
+ * Returns: the number of messages.
+ *
+ * Since: 1.4
+ */
+guint64 qrtr_traffic_generator_get_n_failed (QrtrTrafficGenerator *self);
+
+/**
+ * qrtr_traffic_config_next_size:
+ * @config: a #QrtrTrafficConfig.
+ * @rand: a #GRand.
+ *
+ * Gets the size of the next message as per the size distribution in
+ * @config, so that clients can generate requests with the same
+ * distributions as the generator.
+ *
+ * Returns: the size in bytes.
+ *
+ * Since: 1.4
+ */
+gsize qrtr_traffic_config_next_size (const QrtrTrafficConfig *config,
+                                     GRand                   *rand);
+
+/**
+ * qrtr_traffic_config_next_interval:
+ * @config: a #QrtrTrafficConfig.
+ * @rand: a #GRand.
+ *
+ * Gets the interval until the next message as per the rate and interval
+ * distribution in @config.
+ *
+ * The interval is fractional, so that the time of the next message can be
+ * accumulated without drifting from the rate.
+ *
+ * Returns: the interval in microseconds, or %G_MAXDOUBLE if the rate is not
+ *  positive.
+ *
+ * Since: 1.4
+ */
+gdouble qrtr_traffic_config_next_interval (const QrtrTrafficConfig *config,
+                                           GRand                   *rand);
+
+/**
+ * qrtr_traffic_message_new:
+ * @sequence: the sequence number of the message.
+ * @size: the size of the message.
+ *
+ * Creates a new message with the header expected by #QrtrTrafficStats, and
+ * timestamped with the current monotonic time. The size is clamped to
+ * %QRTR_TRAFFIC_MESSAGE_MIN_SIZE and %QRTR_TRAFFIC_MESSAGE_MAX_SIZE.
+ *
+ * Returns: (transfer full): a #GBytes.
+ *
+ * Since: 1.4
+ */
+GBytes *qrtr_traffic_message_new (guint32 sequence,
+                                  gsize   size);
+
+/**
+ * qrtr_traffic_stats_add_message:
+ * @stats: a #QrtrTrafficStats.
+ * @message: a message received.
+ *
+ * Accounts a received message in @stats.
+ *
+ * Returns: %TRUE if the message was accounted, or %FALSE if it wasn't a
+ *  generated message.
+ *
+ * Since: 1.4
+ */
+gboolean qrtr_traffic_stats_add_message (QrtrTrafficStats *stats,
+                                         GBytes           *message);
+
+G_END_DECLS
+
+#endif /* _LIBQRTR_GLIB_QRTR_TRAFFIC_H_ */
@@ -18,6 +18,8 @@ G_BEGIN_DECLS
 typedef struct _QrtrBus         QrtrBus;
 typedef struct _QrtrClient      QrtrClient;
 typedef struct _QrtrNode        QrtrNode;
+typedef struct _QrtrServer      QrtrServer;
+typedef struct _QrtrTrafficGenerator QrtrTrafficGenerator;
 
 G_END_DECLS
 
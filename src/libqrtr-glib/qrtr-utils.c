@@ -9,8 +9,11 @@
 
 #include "qrtr-utils.h"
 
+#include <errno.h>
+#include <linux/qrtr.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 
 /* Some kernels expose the qrtr header but not the address family macro. */
 #if !defined AF_QIPCRTR
@@ -47,3 +50,41 @@ qrtr_get_node_for_uri (const gchar *name,
 
     return TRUE;
 }
+
+gboolean
+qrtr_socket_bind_local (gint      fd,
+                        guint32  *node_id,
+                        guint32  *port,
+                        GError  **error)
+{
+    struct sockaddr_qrtr addr;
+    socklen_t            len;
+
+    /* The socket is created with the local node id but without port until
+     * it's bound; binding to port 0 gets an ephemeral port assigned. */
+    len = sizeof (addr);
+    if (getsockname (fd, (struct sockaddr *)&addr, &len) < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Failed to get socket name: %s", g_strerror (errno));
+        return FALSE;
+    }
+    g_assert (len == sizeof (addr) && addr.sq_family == AF_QIPCRTR);
+
+    addr.sq_port = 0;
+    if (bind (fd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Failed to bind socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    len = sizeof (addr);
+    if (getsockname (fd, (struct sockaddr *)&addr, &len) < 0) {
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                     "Failed to get socket name: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    *node_id = addr.sq_node;
+    *port = addr.sq_port;
+    return TRUE;
+}
@@ -50,4 +50,25 @@ gchar *qrtr_get_uri_for_node (guint32 node_id);
 gboolean qrtr_get_node_for_uri (const gchar *uri,
                                 guint32     *node_id);
 
+/* Other private methods */
+
+#if defined (LIBQRTR_GLIB_COMPILATION)
+
+G_GNUC_INTERNAL
+gboolean qrtr_socket_bind_local (gint      fd,
+                                 guint32  *node_id,
+                                 guint32  *port,
+                                 GError  **error);
+
+/* Key of a QRTR address (node, port), e.g. for g_int64_hash() tables; built
+ * unsigned, as node ids may use the whole 32 bits */
+static inline guint64
+qrtr_address_key (guint32 node_id,
+                  guint32 port)
+{
+    return ((guint64) node_id << 32) | port;
+}
+
+#endif
+
 #endif /* _LIBQRTR_GLIB_QRTR_UTILS_H_ */
@@ -0,0 +1,341 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+/*
+ * Benchmark of the recovery of the bus view when control packets are lost,
+ * duplicated, truncated or reordered.
+ *
+ * The bus runs against the fake name service, which injects the faults. In
+ * every round a burst of random server changes is applied to the name
+ * service, and the main loop runs until the bus and the name service are
+ * idle. The bus view is then compared with the name service: the round
+ * either converged, and the time and CPU time it took are accounted, or the
+ * faults left the view diverged with nothing for the bus to detect, e.g. a
+ * truncated packet, and the bus is created again to start the next round
+ * from a known state. The CPU time includes the fake name service.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libqrtr-glib.h>
+
+#include "test-fake-ns.h"
+
+#define LOOKUP_TIMEOUT_MS 5000
+#define FIRST_PORT        0x1000
+
+/* options */
+static gint     n_nodes = 16;
+static gint     n_ports = 16;
+static gint     n_rounds = 100;
+static gint     n_changes = 64;
+static gdouble  drop_rate = 0.01;
+static gdouble  duplicate_rate = 0.01;
+static gdouble  truncate_rate;
+static gdouble  reorder_rate = 0.05;
+static gint     seed = 42;
+
+static GOptionEntry main_entries[] = {
+    { "nodes", 'n', 0, G_OPTION_ARG_INT, &n_nodes,
+      "Number of nodes (default: 16)",
+      "[NODES]"
+    },
+    { "ports", 'p', 0, G_OPTION_ARG_INT, &n_ports,
+      "Number of server ports per node (default: 16)",
+      "[PORTS]"
+    },
+    { "rounds", 'r', 0, G_OPTION_ARG_INT, &n_rounds,
+      "Number of rounds (default: 100)",
+      "[ROUNDS]"
+    },
+    { "changes", 'c', 0, G_OPTION_ARG_INT, &n_changes,
+      "Number of server changes per round (default: 64)",
+      "[CHANGES]"
+    },
+    { "drop", 0, 0, G_OPTION_ARG_DOUBLE, &drop_rate,
+      "Probability of dropping a packet (default: 0.01)",
+      "[P]"
+    },
+    { "duplicate", 0, 0, G_OPTION_ARG_DOUBLE, &duplicate_rate,
+      "Probability of duplicating a packet (default: 0.01)",
+      "[P]"
+    },
+    { "truncate", 0, 0, G_OPTION_ARG_DOUBLE, &truncate_rate,
+      "Probability of truncating a packet (default: 0)",
+      "[P]"
+    },
+    { "reorder", 0, 0, G_OPTION_ARG_DOUBLE, &reorder_rate,
+      "Probability of swapping a packet with the next one (default: 0.05)",
+      "[P]"
+    },
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed,
+      "Seed of the random number generator (default: 42)",
+      "[SEED]"
+    },
+    { NULL }
+};
+
+typedef struct {
+    GMainLoop        *loop;
+    TestFakeNs       *ns;
+    TestFakeNsFaults  faults;
+    GRand            *rand;
+
+    QrtrBus *bus;
+    GError  *error;
+    gulong   subscription_id;
+    guint64  dropped_packets;
+
+    /* bus view */
+    guint   n_view;
+    guint64 view_fingerprint;
+
+    /* results */
+    guint  n_converged;
+    guint  n_diverged;
+    gint64 total_time;
+    gint64 max_time;
+    gint64 total_cpu_time;
+} Context;
+
+/*****************************************************************************/
+
+static gint64
+get_cpu_time (void)
+{
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_PROCESS_CPUTIME_ID, &ts) < 0)
+        return 0;
+    return (gint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static void
+view_update (Context                    *ctx,
+             gboolean                    added,
+             const QrtrBusServiceRecord *record)
+{
+    guint64 hash;
+
+    hash = test_fake_ns_server_hash (record->node_id, record->port, record->service,
+                                     record->version, record->instance);
+    if (added) {
+        ctx->n_view++;
+        ctx->view_fingerprint += hash;
+    } else {
+        g_assert (ctx->n_view > 0);
+        ctx->n_view--;
+        ctx->view_fingerprint -= hash;
+    }
+}
+
+static void
+service_cb (QrtrBus                    *bus,
+            gboolean                    added,
+            const QrtrBusServiceRecord *record,
+            Context                    *ctx)
+{
+    view_update (ctx, added, record);
+}
+
+static gboolean
+view_converged (Context *ctx)
+{
+    return (ctx->n_view == test_fake_ns_get_n_servers (ctx->ns) &&
+            ctx->view_fingerprint == test_fake_ns_get_fingerprint (ctx->ns));
+}
+
+/*****************************************************************************/
+
+static void
+bus_new_ready (GObject      *source,
+               GAsyncResult *res,
+               Context      *ctx)
+{
+    ctx->bus = qrtr_bus_new_finish (res, &ctx->error);
+    g_main_loop_quit (ctx->loop);
+}
+
+static gboolean
+bus_start (Context *ctx)
+{
+    g_autoptr(GArray) snapshot = NULL;
+    guint             i;
+
+    /* the initial lookup is not benchmarked, and it must complete */
+    test_fake_ns_set_faults (ctx->ns, NULL);
+    qrtr_bus_new (LOOKUP_TIMEOUT_MS, NULL, (GAsyncReadyCallback) bus_new_ready, ctx);
+    g_main_loop_run (ctx->loop);
+    test_fake_ns_set_faults (ctx->ns, &ctx->faults);
+    if (!ctx->bus) {
+        g_printerr ("error: couldn't create bus: %s\n", ctx->error->message);
+        return FALSE;
+    }
+
+    ctx->n_view = 0;
+    ctx->view_fingerprint = 0;
+    snapshot = qrtr_bus_subscribe_services (ctx->bus, (QrtrBusServiceFunc) service_cb, ctx, NULL,
+                                            &ctx->subscription_id);
+    for (i = 0; i < snapshot->len; i++)
+        view_update (ctx, TRUE, &g_array_index (snapshot, QrtrBusServiceRecord, i));
+    return TRUE;
+}
+
+static void
+bus_stop (Context *ctx)
+{
+    ctx->dropped_packets += qrtr_bus_get_dropped_packets (ctx->bus);
+    qrtr_bus_unsubscribe_services (ctx->bus, ctx->subscription_id);
+    g_clear_object (&ctx->bus);
+}
+
+/*****************************************************************************/
+
+static void
+apply_random_change (Context *ctx)
+{
+    guint32 node_id;
+    guint32 port;
+
+    node_id = (guint32) g_rand_int_range (ctx->rand, 0, n_nodes) + TEST_FAKE_NS_LOCAL_NODE + 1;
+    port = (guint32) g_rand_int_range (ctx->rand, 0, n_ports) + FIRST_PORT;
+    if (!test_fake_ns_remove_server (ctx->ns, node_id, port))
+        test_fake_ns_add_server (ctx->ns, node_id, port,
+                                 (guint32) g_rand_int_range (ctx->rand, 1, 64),
+                                 (guint32) g_rand_int_range (ctx->rand, 1, 4),
+                                 0);
+}
+
+static gboolean
+idle_cb (Context *ctx)
+{
+    /* dispatched at low priority, so only once the control socket of the
+     * bus is drained, but the name service may still have packets to send */
+    if (!test_fake_ns_is_idle (ctx->ns))
+        return G_SOURCE_CONTINUE;
+
+    g_main_loop_quit (ctx->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+run_round (Context *ctx)
+{
+    gint64 start_time;
+    gint64 start_cpu_time;
+    gint64 elapsed;
+    gint   i;
+
+    start_time = g_get_monotonic_time ();
+    start_cpu_time = get_cpu_time ();
+
+    for (i = 0; i < n_changes; i++)
+        apply_random_change (ctx);
+
+    g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) idle_cb, ctx, NULL);
+    g_main_loop_run (ctx->loop);
+
+    if (!view_converged (ctx)) {
+        ctx->n_diverged++;
+        bus_stop (ctx);
+        return bus_start (ctx);
+    }
+
+    elapsed = g_get_monotonic_time () - start_time;
+    ctx->n_converged++;
+    ctx->total_time += elapsed;
+    ctx->max_time = MAX (ctx->max_time, elapsed);
+    ctx->total_cpu_time += get_cpu_time () - start_cpu_time;
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+report (Context *ctx)
+{
+    TestFakeNsStats stats;
+
+    test_fake_ns_get_stats (ctx->ns, &stats);
+    g_print ("faults: %" G_GUINT64_FORMAT " packets, %" G_GUINT64_FORMAT " dropped, "
+             "%" G_GUINT64_FORMAT " duplicated, %" G_GUINT64_FORMAT " truncated, "
+             "%" G_GUINT64_FORMAT " reordered\n",
+             stats.n_packets, stats.n_dropped, stats.n_duplicated, stats.n_truncated, stats.n_reordered);
+    g_print ("drops detected by the bus: %" G_GUINT64_FORMAT "\n", ctx->dropped_packets);
+    g_print ("rounds: %u converged, %u diverged\n", ctx->n_converged, ctx->n_diverged);
+    if (ctx->n_converged)
+        g_print ("convergence: mean %.3f ms (max %.3f ms), mean CPU time %.3f ms\n",
+                 (gdouble) ctx->total_time / ctx->n_converged / 1000.0,
+                 (gdouble) ctx->max_time / 1000.0,
+                 (gdouble) ctx->total_cpu_time / ctx->n_converged / 1000.0);
+}
+
+int
+main (int argc, char **argv)
+{
+    g_autoptr(GOptionContext) option_context = NULL;
+    g_autoptr(GError)         error = NULL;
+    Context                   ctx;
+    gint                      exit_status = EXIT_SUCCESS;
+    gint                      i;
+    gint                      j;
+
+    option_context = g_option_context_new ("- Benchmark of the bus recovery from control packet faults");
+    g_option_context_add_main_entries (option_context, main_entries, NULL);
+    if (!g_option_context_parse (option_context, &argc, &argv, &error)) {
+        g_printerr ("error: couldn't parse option context: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    if (n_nodes <= 0 || n_ports <= 0 || n_rounds < 0 || n_changes < 0) {
+        g_printerr ("error: invalid benchmark size\n");
+        return EXIT_FAILURE;
+    }
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.ns = test_fake_ns_new ((guint32) seed);
+    ctx.rand = g_rand_new_with_seed ((guint32) seed);
+    ctx.faults.drop = drop_rate;
+    ctx.faults.duplicate = duplicate_rate;
+    ctx.faults.truncate = truncate_rate;
+    ctx.faults.reorder = reorder_rate;
+
+    /* start with half of the ports in use, without faults */
+    for (i = 0; i < n_nodes; i++) {
+        for (j = 0; j < n_ports; j += 2)
+            test_fake_ns_add_server (ctx.ns, (guint32) i + TEST_FAKE_NS_LOCAL_NODE + 1,
+                                     (guint32) j + FIRST_PORT, (guint32) j + 1, 1, 0);
+    }
+
+    if (bus_start (&ctx)) {
+        for (i = 0; i < n_rounds; i++) {
+            if (!run_round (&ctx)) {
+                exit_status = EXIT_FAILURE;
+                break;
+            }
+        }
+
+        if (ctx.bus)
+            bus_stop (&ctx);
+        report (&ctx);
+    } else
+        exit_status = EXIT_FAILURE;
+
+    g_clear_error (&ctx.error);
+    g_rand_free (ctx.rand);
+    test_fake_ns_free (ctx.ns);
+    g_main_loop_unref (ctx.loop);
+
+    return exit_status;
+}
@@ -0,0 +1,299 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+/*
+ * Benchmark of the threaded dispatch of the client messages.
+ *
+ * A number of clients with threaded dispatch are given messages through the
+ * fake name service, as if sent by their servers, and the message handler
+ * spins for a while to stand for the processing of each message. The run is
+ * repeated with 1, 2, 4... worker threads, up to the number of processors,
+ * and the rate of messages handled is reported for each. The handler checks
+ * that the messages of every client are received in the order sent.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libqrtr-glib.h>
+
+#include "test-fake-ns.h"
+
+#define LOOKUP_TIMEOUT_MS 5000
+#define FIRST_PORT        0x1000
+#define SERVER_NODE_ID    (TEST_FAKE_NS_LOCAL_NODE + 1)
+
+/* options */
+static gint n_clients = 32;
+static gint n_messages = 1000;
+static gint message_size = 64;
+static gint work_us = 20;
+static gint max_threads;
+
+static GOptionEntry main_entries[] = {
+    { "clients", 'c', 0, G_OPTION_ARG_INT, &n_clients,
+      "Number of clients (default: 32)",
+      "[CLIENTS]"
+    },
+    { "messages", 'm', 0, G_OPTION_ARG_INT, &n_messages,
+      "Number of messages per client in each run (default: 1000)",
+      "[MESSAGES]"
+    },
+    { "size", 's', 0, G_OPTION_ARG_INT, &message_size,
+      "Size of the messages in bytes, at least 4 (default: 64)",
+      "[SIZE]"
+    },
+    { "work", 'w', 0, G_OPTION_ARG_INT, &work_us,
+      "Time spent handling each message in microseconds (default: 20)",
+      "[US]"
+    },
+    { "threads", 't', 0, G_OPTION_ARG_INT, &max_threads,
+      "Maximum number of worker threads (default: number of processors)",
+      "[THREADS]"
+    },
+    { NULL }
+};
+
+typedef struct _Context Context;
+
+typedef struct {
+    Context    *ctx;
+    QrtrClient *client;
+    guint32     port;
+    guint32     local_port;
+    guint       n_sent;
+    /* only accessed by the strand of the client */
+    guint32     next_sequence;
+} Peer;
+
+struct _Context {
+    GMainLoop  *loop;
+    TestFakeNs *ns;
+    QrtrBus    *bus;
+    GError     *error;
+    Peer       *peers;
+    guint8     *message;
+
+    gint n_received;
+    gint n_out_of_order;
+};
+
+/*****************************************************************************/
+
+static void
+message_bytes_cb (QrtrClient *client,
+                  GBytes     *bytes,
+                  Peer       *peer)
+{
+    const guint8 *data;
+    gsize         size;
+    guint32       sequence;
+    gint64        end_time;
+
+    data = g_bytes_get_data (bytes, &size);
+    g_assert (size >= sizeof (sequence));
+    memcpy (&sequence, data, sizeof (sequence));
+    sequence = GUINT32_FROM_LE (sequence);
+    if (sequence != peer->next_sequence)
+        g_atomic_int_inc (&peer->ctx->n_out_of_order);
+    peer->next_sequence = sequence + 1;
+
+    end_time = g_get_monotonic_time () + work_us;
+    while (g_get_monotonic_time () < end_time)
+        ;
+
+    g_atomic_int_inc (&peer->ctx->n_received);
+}
+
+/*****************************************************************************/
+
+static void
+bus_new_ready (GObject      *source,
+               GAsyncResult *res,
+               Context      *ctx)
+{
+    ctx->bus = qrtr_bus_new_finish (res, &ctx->error);
+    g_main_loop_quit (ctx->loop);
+}
+
+static gboolean
+clients_start (Context *ctx)
+{
+    g_autoptr(QrtrNode) node = NULL;
+    gint                i;
+
+    for (i = 0; i < n_clients; i++)
+        test_fake_ns_add_server (ctx->ns, SERVER_NODE_ID, (guint32) i + FIRST_PORT, (guint32) i + 1, 1, 0);
+
+    qrtr_bus_new (LOOKUP_TIMEOUT_MS, NULL, (GAsyncReadyCallback) bus_new_ready, ctx);
+    g_main_loop_run (ctx->loop);
+    if (!ctx->bus) {
+        g_printerr ("error: couldn't create bus: %s\n", ctx->error->message);
+        return FALSE;
+    }
+
+    node = qrtr_bus_get_node (ctx->bus, SERVER_NODE_ID);
+    if (!node) {
+        g_printerr ("error: couldn't find node %u\n", SERVER_NODE_ID);
+        return FALSE;
+    }
+
+    ctx->peers = g_new0 (Peer, n_clients);
+    for (i = 0; i < n_clients; i++) {
+        Peer *peer = &ctx->peers[i];
+
+        peer->ctx = ctx;
+        peer->port = (guint32) i + FIRST_PORT;
+        peer->client = g_initable_new (QRTR_TYPE_CLIENT, NULL, &ctx->error,
+                                       QRTR_CLIENT_NODE, node,
+                                       QRTR_CLIENT_PORT, peer->port,
+                                       QRTR_CLIENT_DISPATCH_THREADED, TRUE,
+                                       NULL);
+        if (!peer->client) {
+            g_printerr ("error: couldn't create client: %s\n", ctx->error->message);
+            return FALSE;
+        }
+        peer->local_port = test_fake_ns_get_last_port (ctx->ns);
+        g_signal_connect (peer->client, QRTR_CLIENT_SIGNAL_MESSAGE_BYTES,
+                          G_CALLBACK (message_bytes_cb), peer);
+    }
+    return TRUE;
+}
+
+static void
+clients_stop (Context *ctx)
+{
+    gint i;
+
+    /* the workers release the clients in the main context */
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+
+    if (ctx->peers) {
+        for (i = 0; i < n_clients; i++)
+            g_clear_object (&ctx->peers[i].client);
+        g_free (ctx->peers);
+    }
+    g_clear_object (&ctx->bus);
+}
+
+/*****************************************************************************/
+
+static gboolean
+send_message (Context *ctx,
+              Peer    *peer)
+{
+    guint32 sequence;
+
+    sequence = GUINT32_TO_LE (peer->n_sent);
+    memcpy (ctx->message, &sequence, sizeof (sequence));
+    if (!test_fake_ns_send_message (ctx->ns, SERVER_NODE_ID, peer->port, peer->local_port,
+                                    ctx->message, (gsize) message_size))
+        return FALSE;
+    peer->n_sent++;
+    return TRUE;
+}
+
+static gdouble
+run (Context *ctx,
+     guint    n_threads)
+{
+    gint64 start_time;
+    gint   n_total;
+    gint   i;
+
+    qrtr_client_set_dispatch_threads (n_threads);
+    for (i = 0; i < n_clients; i++) {
+        ctx->peers[i].n_sent = 0;
+        ctx->peers[i].next_sequence = 0;
+    }
+    g_atomic_int_set (&ctx->n_received, 0);
+
+    n_total = n_clients * n_messages;
+    start_time = g_get_monotonic_time ();
+
+    /* Fill the sockets of all the clients, then let the main context read
+     * them; it's woken up by the workers when they release the clients,
+     * which they do after handling the last message queued. */
+    while (g_atomic_int_get (&ctx->n_received) < n_total) {
+        for (i = 0; i < n_clients; i++) {
+            Peer *peer = &ctx->peers[i];
+
+            while (peer->n_sent < (guint) n_messages && send_message (ctx, peer))
+                ;
+        }
+        g_main_context_iteration (NULL, TRUE);
+    }
+
+    return (gdouble) n_total * G_USEC_PER_SEC / (gdouble) (g_get_monotonic_time () - start_time);
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+    g_autoptr(GOptionContext) option_context = NULL;
+    g_autoptr(GError)         error = NULL;
+    Context                   ctx;
+    gint                      exit_status = EXIT_SUCCESS;
+    guint                     n_threads;
+    gdouble                   base_rate = 0.0;
+
+    option_context = g_option_context_new ("- Benchmark of the threaded dispatch of client messages");
+    g_option_context_add_main_entries (option_context, main_entries, NULL);
+    if (!g_option_context_parse (option_context, &argc, &argv, &error)) {
+        g_printerr ("error: couldn't parse option context: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    if (n_clients <= 0 || n_messages <= 0 || message_size < (gint) sizeof (guint32) ||
+        work_us < 0 || max_threads < 0) {
+        g_printerr ("error: invalid benchmark size\n");
+        return EXIT_FAILURE;
+    }
+    if (!max_threads)
+        max_threads = (gint) g_get_num_processors ();
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.ns = test_fake_ns_new (0);
+    ctx.message = g_malloc0 ((gsize) message_size);
+
+    if (clients_start (&ctx)) {
+        /* 1, 2, 4... and the maximum */
+        for (n_threads = 1; ; n_threads = MIN (n_threads * 2, (guint) max_threads)) {
+            gdouble rate;
+
+            rate = run (&ctx, n_threads);
+            if (n_threads == 1)
+                base_rate = rate;
+            g_print ("threads %u: %.0f messages/s (%.2fx)\n", n_threads, rate, rate / base_rate);
+            if (n_threads == (guint) max_threads)
+                break;
+        }
+
+        if (ctx.n_out_of_order) {
+            g_printerr ("error: %d messages received out of order\n", ctx.n_out_of_order);
+            exit_status = EXIT_FAILURE;
+        }
+    } else
+        exit_status = EXIT_FAILURE;
+
+    clients_stop (&ctx);
+
+    g_clear_error (&ctx.error);
+    g_free (ctx.message);
+    test_fake_ns_free (ctx.ns);
+    g_main_loop_unref (ctx.loop);
+
+    return exit_status;
+}
@@ -0,0 +1,138 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+/* aligned_alloc() is only declared for C11 */
+#define _ISOC11_SOURCE
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+
+#include "test-alloc.h"
+
+extern void *__libc_malloc   (size_t size);
+extern void *__libc_calloc   (size_t n, size_t size);
+extern void *__libc_realloc  (void *ptr, size_t size);
+extern void  __libc_free     (void *ptr);
+extern void *__libc_memalign (size_t alignment, size_t size);
+extern void *__libc_valloc   (size_t size);
+
+/* updated from any thread */
+static volatile gssize  used;
+static volatile guint64 n_allocations;
+
+static void
+account (void   *ptr,
+         gssize  sign)
+{
+    if (!ptr)
+        return;
+
+    __sync_fetch_and_add (&used, sign * (gssize) malloc_usable_size (ptr));
+    if (sign > 0)
+        __sync_fetch_and_add (&n_allocations, 1);
+}
+
+gssize
+test_alloc_get_used (void)
+{
+    return __sync_fetch_and_add (&used, 0);
+}
+
+guint64
+test_alloc_get_n_allocations (void)
+{
+    return __sync_fetch_and_add (&n_allocations, 0);
+}
+
+/*****************************************************************************/
+
+void *
+malloc (size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_malloc (size);
+    account (ptr, 1);
+    return ptr;
+}
+
+void *
+calloc (size_t n,
+        size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_calloc (n, size);
+    account (ptr, 1);
+    return ptr;
+}
+
+void *
+realloc (void   *ptr,
+         size_t  size)
+{
+    size_t  old_size;
+    void   *new_ptr;
+
+    old_size = (ptr ? malloc_usable_size (ptr) : 0);
+    new_ptr = __libc_realloc (ptr, size);
+    /* on failure the old block is kept, unless it was a free */
+    if (new_ptr || !size) {
+        __sync_fetch_and_sub (&used, (gssize) old_size);
+        account (new_ptr, 1);
+    }
+    return new_ptr;
+}
+
+void
+free (void *ptr)
+{
+    account (ptr, -1);
+    __libc_free (ptr);
+}
+
+void *
+memalign (size_t alignment,
+          size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_memalign (alignment, size);
+    account (ptr, 1);
+    return ptr;
+}
+
+void *
+aligned_alloc (size_t alignment,
+               size_t size)
+{
+    return memalign (alignment, size);
+}
+
+int
+posix_memalign (void   **ptr,
+                size_t   alignment,
+                size_t   size)
+{
+    if (!alignment || (alignment & (alignment - 1)) || alignment % sizeof (void *))
+        return EINVAL;
+
+    *ptr = memalign (alignment, size);
+    return (*ptr ? 0 : ENOMEM);
+}
+
+void *
+valloc (size_t size)
+{
+    void *ptr;
+
+    ptr = __libc_valloc (size);
+    account (ptr, 1);
+    return ptr;
+}
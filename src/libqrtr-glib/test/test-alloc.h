@@ -0,0 +1,28 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _TEST_ALLOC_H_
+#define _TEST_ALLOC_H_
+
+#include <glib.h>
+
+/*
+ * Counting allocator for the memory budget tests: the malloc family is
+ * interposed in the test executable, and the usable size of every block is
+ * accounted, so that the tests can tell how much heap memory is in use at any
+ * point, and how many allocations were made so far. The blocks are still
+ * allocated by the libc allocator, through the glibc specific __libc_* entry
+ * points.
+ *
+ * GLib must be told to use malloc for slices, with G_SLICE=always-malloc.
+ */
+
+gssize  test_alloc_get_used          (void);
+guint64 test_alloc_get_n_allocations (void);
+
+#endif /* _TEST_ALLOC_H_ */
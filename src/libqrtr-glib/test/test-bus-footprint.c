@@ -0,0 +1,211 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libqrtr-glib.h>
+
+#include "test-alloc.h"
+#include "test-fake-ns.h"
+
+#define LOOKUP_TIMEOUT_MS 5000
+#define N_NODES           100
+#define N_PORTS           20
+#define N_CHANGE_PORTS    5
+#define FIRST_PORT        0x1000
+
+/* Budgets of the heap memory used by a bus, including the allocator rounding
+ * and the spare room in hash tables and arrays: a fixed amount for the bus
+ * itself and its socket, and an amount per node and per server tracked. The
+ * node objects are only created when asked for, and cost more. */
+#define BUS_BUDGET                 (32 * 1024)
+#define NODE_RECORD_BUDGET         1024
+#define SERVICE_BUDGET             256
+#define NODE_OBJECT_BUDGET         4096
+#define SERVICE_NODE_OBJECT_BUDGET 512
+/* memory still in use once the bus is disposed, e.g. grown main context
+ * arrays */
+#define LEAK_BUDGET                1024
+
+/* Budgets of the allocations made by the bus for each server added or
+ * removed once the lookup is over, including the formatting of the debug
+ * messages, which GLib does even if they are not printed. */
+#define NEW_SERVER_ALLOCATIONS_BUDGET 6
+#define DEL_SERVER_ALLOCATIONS_BUDGET 3
+
+/*****************************************************************************/
+
+static void
+flush_main_context (void)
+{
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+}
+
+static void
+bus_new_ready (GObject       *source,
+               GAsyncResult  *res,
+               QrtrBus      **bus)
+{
+    g_autoptr(GError) error = NULL;
+
+    *bus = qrtr_bus_new_finish (res, &error);
+    g_assert_no_error (error);
+}
+
+static QrtrBus *
+bus_new (void)
+{
+    QrtrBus *bus = NULL;
+
+    qrtr_bus_new (LOOKUP_TIMEOUT_MS, NULL, (GAsyncReadyCallback) bus_new_ready, &bus);
+    while (!bus)
+        g_main_context_iteration (NULL, TRUE);
+    flush_main_context ();
+    return bus;
+}
+
+static guint64
+flush_main_context_counted (void)
+{
+    guint64 n_allocations;
+
+    n_allocations = test_alloc_get_n_allocations ();
+    flush_main_context ();
+    return test_alloc_get_n_allocations () - n_allocations;
+}
+
+static guint
+bus_count_services (QrtrBus *bus)
+{
+    g_autoptr(GArray)    results = NULL;
+    QrtrBusServiceFilter filter;
+
+    filter.node_id = QRTR_BUS_NODE_ID_ANY;
+    filter.services = NULL;
+    filter.n_services = 0;
+    filter.min_version = 0;
+    filter.max_version = G_MAXUINT32;
+    filter.instance = QRTR_NODE_INSTANCE_ANY;
+
+    results = g_array_new (FALSE, FALSE, sizeof (QrtrBusServiceRecord));
+    return qrtr_bus_query_services (bus, &filter, results);
+}
+
+/*****************************************************************************/
+
+static void
+change_servers (TestFakeNs *ns,
+                gboolean    add,
+                guint64    *n_allocations)
+{
+    guint i;
+    guint j;
+
+    /* Node by node, so that the name service never has to queue packets;
+     * only the allocations made while the bus processes them are counted. */
+    *n_allocations = 0;
+    for (i = 0; i < N_NODES; i++) {
+        for (j = N_PORTS; j < N_PORTS + N_CHANGE_PORTS; j++) {
+            if (add)
+                test_fake_ns_add_server (ns, i + TEST_FAKE_NS_LOCAL_NODE + 1, j + FIRST_PORT, j + 1, 1, 0);
+            else
+                g_assert_true (test_fake_ns_remove_server (ns, i + TEST_FAKE_NS_LOCAL_NODE + 1, j + FIRST_PORT));
+        }
+        *n_allocations += flush_main_context_counted ();
+    }
+}
+
+/*****************************************************************************/
+
+static void
+test_bus_footprint (void)
+{
+    TestFakeNs *ns;
+    QrtrBus    *bus;
+    GList      *nodes;
+    gssize      base;
+    gssize      used;
+    gssize      before_changes;
+    guint64     n_allocations;
+    guint       n_services;
+    guint       n_changes;
+    guint       i;
+    guint       j;
+
+    ns = test_fake_ns_new (0);
+    for (i = 0; i < N_NODES; i++) {
+        for (j = 0; j < N_PORTS; j++)
+            test_fake_ns_add_server (ns, i + TEST_FAKE_NS_LOCAL_NODE + 1, j + FIRST_PORT, j + 1, 1, 0);
+    }
+    n_services = N_NODES * N_PORTS;
+
+    /* the type system and other one-time allocations are not accounted */
+    g_object_unref (bus_new ());
+    flush_main_context ();
+
+    base = test_alloc_get_used ();
+    bus = bus_new ();
+
+    used = test_alloc_get_used () - base;
+    g_test_message ("bus with %u nodes and %u servers: %" G_GSSIZE_FORMAT " bytes", N_NODES, n_services, used);
+    g_assert_cmpuint (bus_count_services (bus), ==, n_services);
+    g_assert_cmpint (used, <=, BUS_BUDGET + N_NODES * NODE_RECORD_BUDGET + n_services * SERVICE_BUDGET);
+
+    /* Servers added and removed after the lookup. A first batch grows the
+     * tables that are not shrunk afterwards, and the second one must give
+     * back everything it took, but for some slack for the main context. */
+    n_changes = N_NODES * N_CHANGE_PORTS;
+    change_servers (ns, TRUE, &n_allocations);
+    change_servers (ns, FALSE, &n_allocations);
+    g_assert_cmpuint (bus_count_services (bus), ==, n_services);
+
+    before_changes = test_alloc_get_used ();
+    change_servers (ns, TRUE, &n_allocations);
+    g_test_message ("%u servers added: %" G_GUINT64_FORMAT " allocations", n_changes, n_allocations);
+    g_assert_cmpuint (bus_count_services (bus), ==, n_services + n_changes);
+    g_assert_cmpuint (n_allocations, <=, (guint64) n_changes * NEW_SERVER_ALLOCATIONS_BUDGET);
+
+    change_servers (ns, FALSE, &n_allocations);
+    g_test_message ("%u servers removed: %" G_GUINT64_FORMAT " allocations", n_changes, n_allocations);
+    g_assert_cmpuint (bus_count_services (bus), ==, n_services);
+    g_assert_cmpuint (n_allocations, <=, (guint64) n_changes * DEL_SERVER_ALLOCATIONS_BUDGET);
+
+    used = test_alloc_get_used () - before_changes;
+    g_test_message ("after removing the servers added: %" G_GSSIZE_FORMAT " bytes", used);
+    g_assert_cmpint (used, <=, LEAK_BUDGET);
+
+    nodes = qrtr_bus_get_nodes (bus);
+    g_assert_cmpuint (g_list_length (nodes), ==, N_NODES);
+    g_list_free_full (nodes, g_object_unref);
+
+    used = test_alloc_get_used () - base;
+    g_test_message ("bus with %u node objects: %" G_GSSIZE_FORMAT " bytes", N_NODES, used);
+    g_assert_cmpint (used, <=, BUS_BUDGET + N_NODES * NODE_OBJECT_BUDGET + n_services * SERVICE_NODE_OBJECT_BUDGET);
+
+    g_object_unref (bus);
+    flush_main_context ();
+
+    used = test_alloc_get_used () - base;
+    g_test_message ("after disposing the bus: %" G_GSSIZE_FORMAT " bytes", used);
+    g_assert_cmpint (used, <=, LEAK_BUDGET);
+
+    test_fake_ns_free (ns);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libqrtr-glib/bus/footprint", test_bus_footprint);
+
+    return g_test_run ();
+}
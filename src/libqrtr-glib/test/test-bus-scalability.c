@@ -0,0 +1,355 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libqrtr-glib.h>
+
+#include "test-fake-ns.h"
+
+#define LOOKUP_TIMEOUT_MS  30000
+#define N_NODES            500
+#define N_PORTS            100
+#define FIRST_PORT         0x1000
+#define NODE_LOOKUP_ROUNDS 100
+
+/* Every phase is run with N_NODES and twice as many nodes, each N_RUNS times
+ * keeping the fastest, and must not take more than MAX_RATIO times longer
+ * with twice the nodes: enough room for noise on loaded machines, but not
+ * for processing that grows faster than the number of servers. Phases faster
+ * than MIN_PHASE_TIME_US are compared against that time instead, as their
+ * timing is mostly noise. */
+#define N_RUNS            2
+#define MAX_RATIO         2.5
+#define MIN_PHASE_TIME_US 1000
+
+typedef enum {
+    PHASE_LOOKUP,
+    PHASE_REMOVAL,
+    PHASE_ADDITION,
+    PHASE_NODE_OBJECTS,
+    PHASE_NODE_LOOKUP,
+    PHASE_REMOVAL_WITH_NODES,
+    PHASE_SERVICE_WAITERS,
+    PHASE_NODE_WAITERS,
+    PHASE_TEARDOWN,
+    N_PHASES
+} Phase;
+
+static const gchar *phase_names[N_PHASES] = {
+    "lookup",
+    "removal",
+    "addition",
+    "node objects",
+    "node lookup",
+    "removal with node objects",
+    "service waiters",
+    "node waiters",
+    "teardown",
+};
+
+/*****************************************************************************/
+
+typedef struct {
+    GMainLoop  *loop;
+    TestFakeNs *ns;
+    QrtrBus    *bus;
+    guint       n_nodes;
+    guint       n_pending;
+    gint64      phase_start_time;
+} Context;
+
+static gboolean
+wait_idle_cb (Context *ctx)
+{
+    if (!test_fake_ns_is_idle (ctx->ns))
+        return G_SOURCE_CONTINUE;
+
+    g_main_loop_quit (ctx->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+wait_idle (Context *ctx)
+{
+    g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) wait_idle_cb, ctx, NULL);
+    g_main_loop_run (ctx->loop);
+}
+
+static void
+bus_new_ready (GObject      *source,
+               GAsyncResult *res,
+               Context      *ctx)
+{
+    g_autoptr(GError) error = NULL;
+
+    ctx->bus = qrtr_bus_new_finish (res, &error);
+    g_assert_no_error (error);
+    g_main_loop_quit (ctx->loop);
+}
+
+static guint
+bus_count_services (QrtrBus *bus)
+{
+    g_autoptr(GArray)    results = NULL;
+    QrtrBusServiceFilter filter;
+
+    filter.node_id = QRTR_BUS_NODE_ID_ANY;
+    filter.services = NULL;
+    filter.n_services = 0;
+    filter.min_version = 0;
+    filter.max_version = G_MAXUINT32;
+    filter.instance = QRTR_NODE_INSTANCE_ANY;
+
+    results = g_array_new (FALSE, FALSE, sizeof (QrtrBusServiceRecord));
+    return qrtr_bus_query_services (bus, &filter, results);
+}
+
+static guint32
+node_id_get (guint i)
+{
+    return i + TEST_FAKE_NS_LOCAL_NODE + 1;
+}
+
+static void
+phase_start (Context *ctx)
+{
+    ctx->phase_start_time = g_get_monotonic_time ();
+}
+
+static void
+phase_end (Context *ctx,
+           Phase    phase,
+           gint64  *times)
+{
+    gint64 elapsed;
+
+    elapsed = g_get_monotonic_time () - ctx->phase_start_time;
+    times[phase] = (times[phase] < 0) ? elapsed : MIN (times[phase], elapsed);
+}
+
+/*****************************************************************************/
+
+static void
+change_servers (Context  *ctx,
+                gboolean  add,
+                guint     first,
+                guint     n_ports)
+{
+    guint i;
+    guint j;
+
+    /* port by port across all nodes, so that every node sees changes
+     * scattered over the whole run */
+    for (j = first; j < first + n_ports; j++) {
+        for (i = 0; i < ctx->n_nodes; i++) {
+            if (add)
+                test_fake_ns_add_server (ctx->ns, node_id_get (i), j + FIRST_PORT, j + 1, 1, 0);
+            else
+                g_assert_true (test_fake_ns_remove_server (ctx->ns, node_id_get (i), j + FIRST_PORT));
+        }
+    }
+}
+
+static void
+wait_for_node_ready (QrtrBus      *bus,
+                     GAsyncResult *res,
+                     Context      *ctx)
+{
+    g_autoptr(GError)   error = NULL;
+    g_autoptr(QrtrNode) node = NULL;
+
+    node = qrtr_bus_wait_for_node_finish (bus, res, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (node);
+
+    g_assert_cmpuint (ctx->n_pending, >, 0);
+    if (--ctx->n_pending == 0)
+        g_main_loop_quit (ctx->loop);
+}
+
+static void
+wait_for_services_ready (QrtrNode     *node,
+                         GAsyncResult *res,
+                         Context      *ctx)
+{
+    g_autoptr(GError) error = NULL;
+
+    g_assert_true (qrtr_node_wait_for_services_finish (node, res, &error));
+    g_assert_no_error (error);
+
+    g_assert_cmpuint (ctx->n_pending, >, 0);
+    if (--ctx->n_pending == 0)
+        g_main_loop_quit (ctx->loop);
+}
+
+/*****************************************************************************/
+
+static void
+run_phases (guint   n_nodes,
+            gint64 *times)
+{
+    Context            ctx;
+    g_autoptr(GArray)  services = NULL;
+    GList             *nodes;
+    GList             *l;
+    guint              n_services;
+    guint              i;
+    guint              j;
+
+    n_services = n_nodes * N_PORTS;
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.ns = test_fake_ns_new (0);
+    ctx.bus = NULL;
+    ctx.n_nodes = n_nodes;
+    ctx.n_pending = 0;
+    change_servers (&ctx, TRUE, 0, N_PORTS);
+
+    /* initial lookup of all the servers */
+    phase_start (&ctx);
+    qrtr_bus_new (LOOKUP_TIMEOUT_MS, NULL, (GAsyncReadyCallback) bus_new_ready, &ctx);
+    g_main_loop_run (ctx.loop);
+    wait_idle (&ctx);
+    phase_end (&ctx, PHASE_LOOKUP, times);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, n_services);
+
+    /* removal of half of the servers, and addition again, without node
+     * objects; the first ports announced are removed first */
+    phase_start (&ctx);
+    change_servers (&ctx, FALSE, 0, N_PORTS / 2);
+    wait_idle (&ctx);
+    phase_end (&ctx, PHASE_REMOVAL, times);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, n_services - n_nodes * (N_PORTS / 2));
+
+    phase_start (&ctx);
+    change_servers (&ctx, TRUE, 0, N_PORTS / 2);
+    wait_idle (&ctx);
+    phase_end (&ctx, PHASE_ADDITION, times);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, n_services);
+
+    /* creation of all the node objects */
+    phase_start (&ctx);
+    nodes = qrtr_bus_get_nodes (ctx.bus);
+    phase_end (&ctx, PHASE_NODE_OBJECTS, times);
+    g_assert_cmpuint (g_list_length (nodes), ==, n_nodes);
+
+    /* lookups of the node objects, by id */
+    phase_start (&ctx);
+    for (j = 0; j < NODE_LOOKUP_ROUNDS; j++) {
+        for (i = 0; i < n_nodes; i++) {
+            QrtrNode *node;
+
+            g_assert_nonnull (qrtr_bus_peek_node (ctx.bus, node_id_get (i)));
+            node = qrtr_bus_get_node (ctx.bus, node_id_get (i));
+            g_assert_nonnull (node);
+            g_object_unref (node);
+        }
+    }
+    phase_end (&ctx, PHASE_NODE_LOOKUP, times);
+
+    /* removal of the last half of the servers, with node objects */
+    phase_start (&ctx);
+    change_servers (&ctx, FALSE, N_PORTS / 2, N_PORTS - N_PORTS / 2);
+    wait_idle (&ctx);
+    phase_end (&ctx, PHASE_REMOVAL_WITH_NODES, times);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, n_nodes * (N_PORTS / 2));
+
+    /* every node waits for the services removed, which are added again */
+    services = g_array_sized_new (FALSE, FALSE, sizeof (guint32), N_PORTS - N_PORTS / 2);
+    for (j = N_PORTS / 2; j < N_PORTS; j++) {
+        guint32 service;
+
+        service = j + 1;
+        g_array_append_val (services, service);
+    }
+    phase_start (&ctx);
+    for (l = nodes; l; l = g_list_next (l)) {
+        qrtr_node_wait_for_services (QRTR_NODE (l->data), services, LOOKUP_TIMEOUT_MS, NULL,
+                                     (GAsyncReadyCallback) wait_for_services_ready, &ctx);
+        ctx.n_pending++;
+    }
+    change_servers (&ctx, TRUE, N_PORTS / 2, N_PORTS - N_PORTS / 2);
+    g_main_loop_run (ctx.loop);
+    phase_end (&ctx, PHASE_SERVICE_WAITERS, times);
+    g_assert_cmpuint (ctx.n_pending, ==, 0);
+    g_list_free_full (nodes, g_object_unref);
+
+    /* removal of all the nodes, then every node is waited for and comes
+     * back with a single server */
+    change_servers (&ctx, FALSE, 0, N_PORTS);
+    wait_idle (&ctx);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, 0);
+
+    phase_start (&ctx);
+    for (i = 0; i < n_nodes; i++) {
+        qrtr_bus_wait_for_node (ctx.bus, node_id_get (i), LOOKUP_TIMEOUT_MS, NULL,
+                                (GAsyncReadyCallback) wait_for_node_ready, &ctx);
+        ctx.n_pending++;
+    }
+    change_servers (&ctx, TRUE, 0, 1);
+    g_main_loop_run (ctx.loop);
+    phase_end (&ctx, PHASE_NODE_WAITERS, times);
+    g_assert_cmpuint (ctx.n_pending, ==, 0);
+
+    /* disposal of the bus with all the servers and node objects */
+    change_servers (&ctx, TRUE, 1, N_PORTS - 1);
+    wait_idle (&ctx);
+    g_assert_cmpuint (bus_count_services (ctx.bus), ==, n_services);
+    nodes = qrtr_bus_get_nodes (ctx.bus);
+    g_list_free_full (nodes, g_object_unref);
+
+    phase_start (&ctx);
+    g_object_unref (ctx.bus);
+    phase_end (&ctx, PHASE_TEARDOWN, times);
+
+    test_fake_ns_free (ctx.ns);
+    g_main_loop_unref (ctx.loop);
+}
+
+static void
+test_bus_scalability (void)
+{
+    gint64 times[N_PHASES];
+    gint64 times_double[N_PHASES];
+    guint  i;
+
+    for (i = 0; i < N_PHASES; i++) {
+        times[i] = -1;
+        times_double[i] = -1;
+    }
+
+    /* alternate the sizes, so that slow periods of the machine affect both */
+    for (i = 0; i < N_RUNS; i++) {
+        run_phases (N_NODES, times);
+        run_phases (2 * N_NODES, times_double);
+    }
+
+    for (i = 0; i < N_PHASES; i++) {
+        gdouble ratio;
+
+        ratio = (gdouble) times_double[i] / (gdouble) MAX (times[i], MIN_PHASE_TIME_US);
+        g_test_message ("%s: %.3f ms with %u nodes, %.3f ms with %u nodes, ratio %.2f",
+                        phase_names[i],
+                        (gdouble) times[i] / 1000.0, N_NODES,
+                        (gdouble) times_double[i] / 1000.0, 2 * N_NODES,
+                        ratio);
+        g_assert_cmpfloat (ratio, <, MAX_RATIO);
+    }
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/libqrtr-glib/bus/scalability", test_bus_scalability);
+
+    return g_test_run ();
+}
@@ -0,0 +1,708 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/qrtr.h>
+#include <linux/sock_diag.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+/* private helpers of the library */
+#include "qrtr-utils.h"
+
+#include "test-fake-ns.h"
+
+#if defined __SOCKADDR_ARG
+# define SOCKADDR_ARG_PTR(arg) (arg)
+#elif defined __GLIBC__
+/* glibc declares the address arguments as transparent unions in GNU mode */
+# define SOCKADDR_ARG_PTR(arg) ((arg).__sockaddr__)
+#else
+# define __SOCKADDR_ARG        struct sockaddr *
+# define __CONST_SOCKADDR_ARG  const struct sockaddr *
+# define SOCKADDR_ARG_PTR(arg) (arg)
+#endif
+
+#define FIRST_PORT 0x4000
+
+typedef struct {
+    guint64 key;
+    guint32 node_id;
+    guint32 port;
+    guint32 service;
+    guint32 version;
+    guint32 instance;
+    guint64 hash;
+} Server;
+
+typedef struct {
+    struct qrtr_ctrl_pkt packet;
+    gsize                len;
+    /* faults are only considered once per packet */
+    gboolean             faulted;
+} Packet;
+
+typedef struct {
+    TestFakeNs *ns;
+    /* the end given to the library, and the name service end */
+    gint        fd;
+    gint        peer_fd;
+    guint32     port;
+    gboolean    lookup;
+    /* source address of the datagrams received by the library */
+    guint32     sender_node_id;
+    guint32     sender_port;
+    /* Packets not sent yet, as the socket was full */
+    GQueue      queue;
+    guint       writable_id;
+    guint32     drops;
+} Connection;
+
+struct _TestFakeNs {
+    /* node id and port -> Server */
+    GHashTable *servers;
+    guint64     fingerprint;
+
+    /* fd -> Connection */
+    GHashTable *connections;
+    /* port -> Connection */
+    GHashTable *ports;
+    guint32     next_port;
+
+    TestFakeNsFaults faults;
+    GRand           *rand;
+    TestFakeNsStats  stats;
+};
+
+/* The interposed functions may run in any thread, so the connections are
+ * looked up with the lock held; everything else runs in the main thread. */
+G_LOCK_DEFINE_STATIC (fake_ns);
+static TestFakeNs *fake_ns;
+
+static int     (* real_socket)     (int, int, int);
+static int     (* real_close)      (int);
+static int     (* real_bind)       (int, __CONST_SOCKADDR_ARG, socklen_t);
+static int     (* real_getsockname) (int, __SOCKADDR_ARG, socklen_t *);
+static int     (* real_getsockopt) (int, int, int, void *, socklen_t *);
+static ssize_t (* real_sendto)     (int, const void *, size_t, int, __CONST_SOCKADDR_ARG, socklen_t);
+static ssize_t (* real_recvfrom)   (int, void *, size_t, int, __SOCKADDR_ARG, socklen_t *);
+
+static void
+resolve_real_functions (void)
+{
+    if (real_socket)
+        return;
+
+    real_bind = dlsym (RTLD_NEXT, "bind");
+    real_close = dlsym (RTLD_NEXT, "close");
+    real_getsockname = dlsym (RTLD_NEXT, "getsockname");
+    real_getsockopt = dlsym (RTLD_NEXT, "getsockopt");
+    real_recvfrom = dlsym (RTLD_NEXT, "recvfrom");
+    real_sendto = dlsym (RTLD_NEXT, "sendto");
+    real_socket = dlsym (RTLD_NEXT, "socket");
+    g_assert (real_socket && real_close && real_bind && real_getsockname && real_getsockopt &&
+              real_sendto && real_recvfrom);
+}
+
+static Connection *
+peek_connection (gint fd)
+{
+    Connection *connection = NULL;
+
+    G_LOCK (fake_ns);
+    if (fake_ns)
+        connection = g_hash_table_lookup (fake_ns->connections, GINT_TO_POINTER (fd));
+    G_UNLOCK (fake_ns);
+    return connection;
+}
+
+/*****************************************************************************/
+
+static guint64
+mix (guint64 h,
+     guint32 value)
+{
+    /* splitmix64 finalizer */
+    h = (h ^ value) + G_GUINT64_CONSTANT (0x9e3779b97f4a7c15);
+    h = (h ^ (h >> 30)) * G_GUINT64_CONSTANT (0xbf58476d1ce4e5b9);
+    h = (h ^ (h >> 27)) * G_GUINT64_CONSTANT (0x94d049bb133111eb);
+    return h ^ (h >> 31);
+}
+
+guint64
+test_fake_ns_server_hash (guint32 node_id,
+                          guint32 port,
+                          guint32 service,
+                          guint32 version,
+                          guint32 instance)
+{
+    guint64 h = 0;
+
+    h = mix (h, node_id);
+    h = mix (h, port);
+    h = mix (h, service);
+    h = mix (h, version);
+    return mix (h, instance);
+}
+
+static void
+server_free (Server *server)
+{
+    g_slice_free (Server, server);
+}
+
+static void
+packet_free (Packet *packet)
+{
+    g_slice_free (Packet, packet);
+}
+
+/*****************************************************************************/
+
+static gboolean
+roll (TestFakeNs *self,
+      gdouble     probability)
+{
+    return (probability > 0.0 && g_rand_double (self->rand) < probability);
+}
+
+static gboolean
+connection_has_queued_packets (Connection *connection)
+{
+    gint n = 0;
+
+    /* the size of the first datagram queued, if any */
+    return (ioctl (connection->fd, FIONREAD, &n) == 0 && n > 0);
+}
+
+static void connection_flush (Connection *connection);
+
+static gboolean
+connection_writable_cb (gint          fd,
+                        GIOCondition  condition,
+                        Connection   *connection)
+{
+    connection->writable_id = 0;
+    connection_flush (connection);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+connection_flush (Connection *connection)
+{
+    TestFakeNs *self = connection->ns;
+    Packet     *packet;
+
+    while ((packet = g_queue_pop_head (&connection->queue)) != NULL) {
+        if (!packet->faulted) {
+            Packet *next;
+
+            packet->faulted = TRUE;
+            self->stats.n_packets++;
+
+            next = g_queue_peek_head (&connection->queue);
+            if (next && !next->faulted && roll (self, self->faults.reorder)) {
+                g_queue_pop_head (&connection->queue);
+                g_queue_push_head (&connection->queue, packet);
+                g_queue_push_head (&connection->queue, next);
+                self->stats.n_reordered++;
+                continue;
+            }
+
+            if (roll (self, self->faults.drop) && connection_has_queued_packets (connection)) {
+                connection->drops++;
+                self->stats.n_dropped++;
+                packet_free (packet);
+                continue;
+            }
+
+            if (roll (self, self->faults.truncate)) {
+                packet->len = (gsize) g_rand_int_range (self->rand, 0, (gint32) packet->len);
+                self->stats.n_truncated++;
+            }
+
+            if (roll (self, self->faults.duplicate)) {
+                g_queue_push_head (&connection->queue, g_slice_dup (Packet, packet));
+                self->stats.n_duplicated++;
+            }
+        }
+
+        if (send (connection->peer_fd, &packet->packet, packet->len, MSG_DONTWAIT) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                g_queue_push_head (&connection->queue, packet);
+                connection->writable_id = g_unix_fd_add (connection->peer_fd, G_IO_OUT,
+                                                         (GUnixFDSourceFunc) connection_writable_cb,
+                                                         connection);
+                return;
+            }
+            /* the library end is gone */
+        }
+        packet_free (packet);
+    }
+}
+
+static void
+connection_queue_packet (Connection *connection,
+                         guint32     cmd,
+                         guint32     node_id,
+                         guint32     port,
+                         guint32     service,
+                         guint32     version,
+                         guint32     instance)
+{
+    Packet *packet;
+
+    packet = g_slice_new0 (Packet);
+    packet->packet.cmd = GUINT32_TO_LE (cmd);
+    packet->packet.server.node = GUINT32_TO_LE (node_id);
+    packet->packet.server.port = GUINT32_TO_LE (port);
+    packet->packet.server.service = GUINT32_TO_LE (service);
+    packet->packet.server.instance = GUINT32_TO_LE ((instance << 8) | (version & 0xff));
+    packet->len = sizeof (packet->packet);
+    g_queue_push_tail (&connection->queue, packet);
+}
+
+static void
+connection_lookup (Connection *connection)
+{
+    GHashTableIter  iter;
+    Server         *server;
+
+    /* replay all known servers, and finish with an empty one */
+    connection->lookup = TRUE;
+    g_hash_table_iter_init (&iter, connection->ns->servers);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&server))
+        connection_queue_packet (connection, QRTR_TYPE_NEW_SERVER,
+                                 server->node_id, server->port, server->service,
+                                 server->version, server->instance);
+    connection_queue_packet (connection, QRTR_TYPE_NEW_SERVER, 0, 0, 0, 0, 0);
+    if (!connection->writable_id)
+        connection_flush (connection);
+}
+
+static void
+connection_free (Connection *connection)
+{
+    if (connection->writable_id)
+        g_source_remove (connection->writable_id);
+    g_queue_foreach (&connection->queue, (GFunc) packet_free, NULL);
+    g_queue_clear (&connection->queue);
+    real_close (connection->peer_fd);
+    g_slice_free (Connection, connection);
+}
+
+static void
+notify_server (TestFakeNs   *self,
+               guint32       cmd,
+               const Server *server)
+{
+    GHashTableIter  iter;
+    Connection     *connection;
+
+    g_hash_table_iter_init (&iter, self->connections);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&connection)) {
+        if (!connection->lookup)
+            continue;
+        connection_queue_packet (connection, cmd,
+                                 server->node_id, server->port, server->service,
+                                 server->version, server->instance);
+        if (!connection->writable_id)
+            connection_flush (connection);
+    }
+}
+
+/*****************************************************************************/
+/* Interposed socket functions */
+
+int
+socket (int domain,
+        int type,
+        int protocol)
+{
+    Connection *connection;
+    gint        fds[2];
+
+    resolve_real_functions ();
+    if (domain != AF_QIPCRTR || !fake_ns)
+        return real_socket (domain, type, protocol);
+
+    if (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | (type & SOCK_NONBLOCK), 0, fds) < 0)
+        return -1;
+
+    connection = g_slice_new0 (Connection);
+    connection->ns = fake_ns;
+    connection->fd = fds[0];
+    connection->peer_fd = fds[1];
+    connection->sender_node_id = TEST_FAKE_NS_LOCAL_NODE;
+    connection->sender_port = QRTR_PORT_CTRL;
+    g_queue_init (&connection->queue);
+
+    G_LOCK (fake_ns);
+    connection->port = fake_ns->next_port++;
+    g_hash_table_insert (fake_ns->connections, GINT_TO_POINTER (connection->fd), connection);
+    g_hash_table_insert (fake_ns->ports, GUINT_TO_POINTER (connection->port), connection);
+    G_UNLOCK (fake_ns);
+
+    return connection->fd;
+}
+
+int
+close (int fd)
+{
+    Connection *connection = NULL;
+
+    resolve_real_functions ();
+
+    G_LOCK (fake_ns);
+    if (fake_ns) {
+        connection = g_hash_table_lookup (fake_ns->connections, GINT_TO_POINTER (fd));
+        if (connection) {
+            g_hash_table_steal (fake_ns->connections, GINT_TO_POINTER (fd));
+            g_hash_table_remove (fake_ns->ports, GUINT_TO_POINTER (connection->port));
+        }
+    }
+    G_UNLOCK (fake_ns);
+
+    if (connection)
+        connection_free (connection);
+    return real_close (fd);
+}
+
+int
+bind (int                   fd,
+      __CONST_SOCKADDR_ARG  addr,
+      socklen_t             len)
+{
+    Connection                 *connection;
+    const struct sockaddr_qrtr *name;
+
+    resolve_real_functions ();
+    connection = peek_connection (fd);
+    if (!connection)
+        return real_bind (fd, addr, len);
+
+    /* the port was already assigned when the socket was created */
+    name = (const struct sockaddr_qrtr *) SOCKADDR_ARG_PTR (addr);
+    if (!name || len < sizeof (*name) || name->sq_family != AF_QIPCRTR ||
+        (name->sq_port != 0 && name->sq_port != connection->port)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+int
+getsockname (int             fd,
+             __SOCKADDR_ARG  addr,
+             socklen_t      *len)
+{
+    Connection           *connection;
+    struct sockaddr_qrtr  name;
+
+    resolve_real_functions ();
+    connection = peek_connection (fd);
+    if (!connection)
+        return real_getsockname (fd, addr, len);
+
+    memset (&name, 0, sizeof (name));
+    name.sq_family = AF_QIPCRTR;
+    name.sq_node = TEST_FAKE_NS_LOCAL_NODE;
+    name.sq_port = connection->port;
+    memcpy (SOCKADDR_ARG_PTR (addr), &name, MIN (*len, sizeof (name)));
+    *len = sizeof (name);
+    return 0;
+}
+
+int
+getsockopt (int        fd,
+            int        level,
+            int        optname,
+            void      *optval,
+            socklen_t *optlen)
+{
+    Connection *connection;
+    guint32    *meminfo;
+    gint        n = 0;
+
+    resolve_real_functions ();
+    if (real_getsockopt (fd, level, optname, optval, optlen) < 0)
+        return -1;
+
+    connection = peek_connection (fd);
+    if (!connection || level != SOL_SOCKET || optname != SO_MEMINFO)
+        return 0;
+
+    /* datagrams in unix sockets are charged to the sender, so report the
+     * queued packets and the injected drops as AF_QIPCRTR would */
+    meminfo = optval;
+    if (*optlen > SK_MEMINFO_RMEM_ALLOC * sizeof (guint32)) {
+        ioctl (fd, FIONREAD, &n);
+        meminfo[SK_MEMINFO_RMEM_ALLOC] = (guint32) n;
+    }
+    if (*optlen > SK_MEMINFO_DROPS * sizeof (guint32))
+        meminfo[SK_MEMINFO_DROPS] = connection->drops;
+    return 0;
+}
+
+ssize_t
+sendto (int                   fd,
+        const void           *buf,
+        size_t                n,
+        int                   flags,
+        __CONST_SOCKADDR_ARG  addr,
+        socklen_t             addr_len)
+{
+    Connection                 *connection;
+    const struct sockaddr_qrtr *dest;
+    struct qrtr_ctrl_pkt        packet;
+
+    resolve_real_functions ();
+    connection = peek_connection (fd);
+    if (!connection)
+        return real_sendto (fd, buf, n, flags, addr, addr_len);
+
+    dest = (const struct sockaddr_qrtr *) SOCKADDR_ARG_PTR (addr);
+    if (!dest || addr_len < sizeof (*dest) || dest->sq_port != QRTR_PORT_CTRL || n < sizeof (packet.cmd)) {
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    memset (&packet, 0, sizeof (packet));
+    memcpy (&packet, buf, MIN (n, sizeof (packet)));
+    switch (GUINT32_FROM_LE (packet.cmd)) {
+    case QRTR_TYPE_NEW_LOOKUP:
+        connection_lookup (connection);
+        break;
+    case QRTR_TYPE_DEL_LOOKUP:
+        connection->lookup = FALSE;
+        break;
+    default:
+        break;
+    }
+    return (ssize_t) n;
+}
+
+ssize_t
+recvfrom (int              fd,
+          void            *buf,
+          size_t           n,
+          int              flags,
+          __SOCKADDR_ARG   addr,
+          socklen_t       *addr_len)
+{
+    Connection           *connection;
+    struct sockaddr_qrtr  name;
+    ssize_t               ret;
+
+    resolve_real_functions ();
+    connection = peek_connection (fd);
+    if (!connection)
+        return real_recvfrom (fd, buf, n, flags, addr, addr_len);
+
+    ret = real_recvfrom (fd, buf, n, flags, NULL, NULL);
+    if (ret < 0 || !SOCKADDR_ARG_PTR (addr) || !addr_len)
+        return ret;
+
+    memset (&name, 0, sizeof (name));
+    name.sq_family = AF_QIPCRTR;
+    name.sq_node = connection->sender_node_id;
+    name.sq_port = connection->sender_port;
+    memcpy (SOCKADDR_ARG_PTR (addr), &name, MIN (*addr_len, sizeof (name)));
+    *addr_len = sizeof (name);
+    return ret;
+}
+
+/*****************************************************************************/
+
+void
+test_fake_ns_add_server (TestFakeNs *self,
+                         guint32     node_id,
+                         guint32     port,
+                         guint32     service,
+                         guint32     version,
+                         guint32     instance)
+{
+    Server *server;
+    guint64 key;
+
+    key = qrtr_address_key (node_id, port);
+    server = g_hash_table_lookup (self->servers, &key);
+    if (server)
+        self->fingerprint -= server->hash;
+    else {
+        server = g_slice_new (Server);
+        server->key = key;
+        server->node_id = node_id;
+        server->port = port;
+        g_hash_table_insert (self->servers, &server->key, server);
+    }
+
+    server->service = service;
+    server->version = version;
+    server->instance = instance;
+    server->hash = test_fake_ns_server_hash (node_id, port, service, version, instance);
+    self->fingerprint += server->hash;
+
+    notify_server (self, QRTR_TYPE_NEW_SERVER, server);
+}
+
+gboolean
+test_fake_ns_remove_server (TestFakeNs *self,
+                            guint32     node_id,
+                            guint32     port)
+{
+    Server *server;
+    guint64 key;
+
+    key = qrtr_address_key (node_id, port);
+    server = g_hash_table_lookup (self->servers, &key);
+    if (!server)
+        return FALSE;
+
+    self->fingerprint -= server->hash;
+    notify_server (self, QRTR_TYPE_DEL_SERVER, server);
+    g_hash_table_remove (self->servers, &key);
+    return TRUE;
+}
+
+gboolean
+test_fake_ns_has_server (TestFakeNs *self,
+                         guint32     node_id,
+                         guint32     port)
+{
+    guint64 key;
+
+    key = qrtr_address_key (node_id, port);
+    return g_hash_table_contains (self->servers, &key);
+}
+
+guint
+test_fake_ns_get_n_servers (TestFakeNs *self)
+{
+    return g_hash_table_size (self->servers);
+}
+
+guint64
+test_fake_ns_get_fingerprint (TestFakeNs *self)
+{
+    return self->fingerprint;
+}
+
+guint32
+test_fake_ns_get_last_port (TestFakeNs *self)
+{
+    guint32 port;
+
+    G_LOCK (fake_ns);
+    port = self->next_port - 1;
+    G_UNLOCK (fake_ns);
+    return port;
+}
+
+gboolean
+test_fake_ns_send_message (TestFakeNs    *self,
+                           guint32        node_id,
+                           guint32        port,
+                           guint32        dest_port,
+                           gconstpointer  data,
+                           gsize          size)
+{
+    Connection *connection;
+
+    G_LOCK (fake_ns);
+    connection = g_hash_table_lookup (self->ports, GUINT_TO_POINTER (dest_port));
+    G_UNLOCK (fake_ns);
+    g_assert (connection);
+
+    connection->sender_node_id = node_id;
+    connection->sender_port = port;
+    if (send (connection->peer_fd, data, size, MSG_DONTWAIT) < 0) {
+        g_assert (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gboolean
+test_fake_ns_is_idle (TestFakeNs *self)
+{
+    GHashTableIter  iter;
+    Connection     *connection;
+
+    g_hash_table_iter_init (&iter, self->connections);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&connection)) {
+        if (!g_queue_is_empty (&connection->queue) || connection_has_queued_packets (connection))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+void
+test_fake_ns_set_faults (TestFakeNs             *self,
+                         const TestFakeNsFaults *faults)
+{
+    if (faults)
+        self->faults = *faults;
+    else
+        memset (&self->faults, 0, sizeof (self->faults));
+}
+
+void
+test_fake_ns_get_stats (TestFakeNs      *self,
+                        TestFakeNsStats *stats)
+{
+    *stats = self->stats;
+}
+
+TestFakeNs *
+test_fake_ns_new (guint32 seed)
+{
+    TestFakeNs *self;
+
+    resolve_real_functions ();
+
+    self = g_slice_new0 (TestFakeNs);
+    self->servers = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, (GDestroyNotify) server_free);
+    self->connections = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) connection_free);
+    self->ports = g_hash_table_new (g_direct_hash, g_direct_equal);
+    self->next_port = FIRST_PORT;
+    self->rand = g_rand_new_with_seed (seed);
+
+    G_LOCK (fake_ns);
+    g_assert (!fake_ns);
+    fake_ns = self;
+    G_UNLOCK (fake_ns);
+
+    return self;
+}
+
+void
+test_fake_ns_free (TestFakeNs *self)
+{
+    G_LOCK (fake_ns);
+    g_assert (fake_ns == self);
+    fake_ns = NULL;
+    G_UNLOCK (fake_ns);
+
+    /* any library end still open just stops getting packets */
+    g_hash_table_unref (self->ports);
+    g_hash_table_unref (self->connections);
+    g_hash_table_unref (self->servers);
+    g_rand_free (self->rand);
+    g_slice_free (TestFakeNs, self);
+}
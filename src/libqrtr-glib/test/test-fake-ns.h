@@ -0,0 +1,111 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * libqrtr-glib -- GLib/GIO based library to control QRTR devices
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#ifndef _TEST_FAKE_NS_H_
+#define _TEST_FAKE_NS_H_
+
+#include <glib.h>
+
+/*
+ * Fake name service for the tests and benchmarks, so that they run without
+ * QRTR support in the kernel.
+ *
+ * While the fake name service exists, every AF_QIPCRTR socket created in the
+ * process is replaced by one end of a local datagram socket pair, and the
+ * name service sits on the other end. The name service answers lookups with
+ * the servers added to it, and notifies the changes afterwards, as the
+ * kernel name service does. Besides the control socket of a QrtrBus, the
+ * sockets of the clients may be given messages, as if sent by a server.
+ * Everything must run in the global default main context.
+ *
+ * Faults may be injected in the control packets sent:
+ *
+ *   drop       the packet is not sent, and the drop is reported in the socket
+ *              memory info, as the kernel does on receive queue overflows;
+ *              packets are only dropped while others are still queued in the
+ *              socket, as with real overflows
+ *   duplicate  the packet is sent twice in a row
+ *   truncate   the packet is sent truncated
+ *   reorder    the packet is swapped with the next one queued, if any
+ */
+
+#define TEST_FAKE_NS_LOCAL_NODE 1
+
+typedef struct _TestFakeNs TestFakeNs;
+
+/* probabilities of each fault, between 0 and 1 */
+typedef struct {
+    gdouble drop;
+    gdouble duplicate;
+    gdouble truncate;
+    gdouble reorder;
+} TestFakeNsFaults;
+
+typedef struct {
+    guint64 n_packets;
+    guint64 n_dropped;
+    guint64 n_duplicated;
+    guint64 n_truncated;
+    guint64 n_reordered;
+} TestFakeNsStats;
+
+/* Only one fake name service may exist at a time, and it must be freed
+ * after the library objects using it. The seed is the one of the random
+ * number generator used for the faults. */
+TestFakeNs *test_fake_ns_new  (guint32     seed);
+void        test_fake_ns_free (TestFakeNs *self);
+
+/* Faults are disabled with NULL. */
+void test_fake_ns_set_faults (TestFakeNs             *self,
+                              const TestFakeNsFaults *faults);
+void test_fake_ns_get_stats  (TestFakeNs             *self,
+                              TestFakeNsStats        *stats);
+
+/* A server announced in a port already in use replaces the previous one. */
+void     test_fake_ns_add_server    (TestFakeNs *self,
+                                     guint32     node_id,
+                                     guint32     port,
+                                     guint32     service,
+                                     guint32     version,
+                                     guint32     instance);
+gboolean test_fake_ns_remove_server (TestFakeNs *self,
+                                     guint32     node_id,
+                                     guint32     port);
+gboolean test_fake_ns_has_server    (TestFakeNs *self,
+                                     guint32     node_id,
+                                     guint32     port);
+
+/* The servers as a count and an order independent fingerprint, the sum of
+ * the hashes of all of them, so that views can be compared in constant time. */
+guint   test_fake_ns_get_n_servers   (TestFakeNs *self);
+guint64 test_fake_ns_get_fingerprint (TestFakeNs *self);
+guint64 test_fake_ns_server_hash     (guint32     node_id,
+                                      guint32     port,
+                                      guint32     service,
+                                      guint32     version,
+                                      guint32     instance);
+
+/* The local port of the last AF_QIPCRTR socket created, e.g. the one of the
+ * last QrtrClient created. */
+guint32 test_fake_ns_get_last_port (TestFakeNs *self);
+
+/* Sends a message to the socket with the given local port, as if sent from
+ * the given node and port. The sender is kept per socket, so a socket must
+ * only get messages from one sender at a time. Returns FALSE if the socket
+ * is full. */
+gboolean test_fake_ns_send_message (TestFakeNs    *self,
+                                    guint32        node_id,
+                                    guint32        port,
+                                    guint32        dest_port,
+                                    gconstpointer  data,
+                                    gsize          size);
+
+/* Whether all the packets sent so far were received by the library. */
+gboolean test_fake_ns_is_idle (TestFakeNs *self);
+
+#endif /* _TEST_FAKE_NS_H_ */
@@ -0,0 +1,444 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * qrtr-traffic -- Synthetic QRTR traffic for datapath load tests
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+#include <gio/gio.h>
+
+#include <libqrtr-glib.h>
+
+/* interval of the timer sending requests in echo mode */
+#define REQUEST_TICK_MS 1
+/* max number of requests sent in a single tick, enough for the max rate */
+#define REQUEST_TICK_MAX 256
+
+G_STATIC_ASSERT ((gint) QRTR_TRAFFIC_RATE_MAX / 1000 * REQUEST_TICK_MS <= REQUEST_TICK_MAX);
+/* time to wait for the service to show up in the bus */
+#define RESOLVE_TIMEOUT_MS 5000
+
+/* options */
+static gint      service = -1;
+static gint      version = -1;
+static gint      instance = -1;
+static gboolean  client_flag;
+static gchar    *mode_str;
+static gdouble   rate = 1000.0;
+static gchar    *interval_str;
+static gchar    *size_str;
+static gint      min_size = QRTR_TRAFFIC_MESSAGE_MIN_SIZE;
+static gint      max_size = QRTR_TRAFFIC_MESSAGE_MIN_SIZE;
+static gint      duration;
+
+static GOptionEntry main_entries[] = {
+    { "service", 's', 0, G_OPTION_ARG_INT, &service,
+      "Service to publish, or to connect to with --client",
+      "[SERVICE]"
+    },
+    { "version", 'V', 0, G_OPTION_ARG_INT, &version,
+      "Version of the service (default: 0, or any with --client)",
+      "[VERSION]"
+    },
+    { "instance", 'i', 0, G_OPTION_ARG_INT, &instance,
+      "Instance of the service (default: 0, or any with --client)",
+      "[INSTANCE]"
+    },
+    { "client", 'c', 0, G_OPTION_ARG_NONE, &client_flag,
+      "Connect to the service and report the received traffic",
+      NULL
+    },
+    { "mode", 'm', 0, G_OPTION_ARG_STRING, &mode_str,
+      "Echo requests, or send indications (default: indications)",
+      "[echo|indications]"
+    },
+    { "rate", 'r', 0, G_OPTION_ARG_DOUBLE, &rate,
+      "Mean messages per second: indications per client, or requests with --client in echo mode (default: 1000)",
+      "[RATE]"
+    },
+    { "interval", 0, 0, G_OPTION_ARG_STRING, &interval_str,
+      "Distribution of the intervals between messages (default: fixed)",
+      "[fixed|uniform|exponential]"
+    },
+    { "size", 0, 0, G_OPTION_ARG_STRING, &size_str,
+      "Distribution of the message sizes (default: fixed)",
+      "[fixed|uniform|exponential]"
+    },
+    { "min-size", 0, 0, G_OPTION_ARG_INT, &min_size,
+      "Minimum message size",
+      "[BYTES]"
+    },
+    { "max-size", 0, 0, G_OPTION_ARG_INT, &max_size,
+      "Maximum message size",
+      "[BYTES]"
+    },
+    { "duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Seconds to run, or 0 to run until interrupted (default: 0)",
+      "[SECONDS]"
+    },
+    { NULL }
+};
+
+typedef struct {
+    GMainLoop         *loop;
+    QrtrTrafficConfig  config;
+    gint64             start_time;
+    gint64             last_report_time;
+    gint               exit_status;
+
+    /* generator */
+    QrtrServer           *server;
+    QrtrTrafficGenerator *generator;
+    guint64               last_sent;
+    guint64               last_failed;
+
+    /* client */
+    QrtrBus          *bus;
+    QrtrClient       *client;
+    GRand            *rand;
+    QrtrTrafficStats  stats;
+    QrtrTrafficStats  last_stats;
+    guint32           sequence;
+    /* in fractional microseconds */
+    gdouble           next_time;
+    guint64           n_requests;
+    guint64           n_requests_failed;
+} Context;
+
+/*****************************************************************************/
+
+static gboolean
+parse_distribution (const gchar             *str,
+                    QrtrTrafficDistribution *distribution)
+{
+    if (!str || g_str_equal (str, "fixed"))
+        *distribution = QRTR_TRAFFIC_DISTRIBUTION_FIXED;
+    else if (g_str_equal (str, "uniform"))
+        *distribution = QRTR_TRAFFIC_DISTRIBUTION_UNIFORM;
+    else if (g_str_equal (str, "exponential"))
+        *distribution = QRTR_TRAFFIC_DISTRIBUTION_EXPONENTIAL;
+    else {
+        g_printerr ("error: invalid distribution '%s'\n", str);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+parse_config (QrtrTrafficConfig *config)
+{
+    if (!mode_str || g_str_equal (mode_str, "indications"))
+        config->mode = QRTR_TRAFFIC_MODE_INDICATIONS;
+    else if (g_str_equal (mode_str, "echo"))
+        config->mode = QRTR_TRAFFIC_MODE_ECHO;
+    else {
+        g_printerr ("error: invalid mode '%s'\n", mode_str);
+        return FALSE;
+    }
+
+    if (rate <= 0.0 || rate > QRTR_TRAFFIC_RATE_MAX) {
+        g_printerr ("error: rate must be positive and at most %.0f\n", QRTR_TRAFFIC_RATE_MAX);
+        return FALSE;
+    }
+    config->rate = rate;
+
+    if (!parse_distribution (interval_str, &config->interval_distribution) ||
+        !parse_distribution (size_str, &config->size_distribution))
+        return FALSE;
+
+    if (min_size < QRTR_TRAFFIC_MESSAGE_MIN_SIZE || max_size > QRTR_TRAFFIC_MESSAGE_MAX_SIZE) {
+        g_printerr ("error: message sizes must be between %u and %u bytes\n",
+                    QRTR_TRAFFIC_MESSAGE_MIN_SIZE, QRTR_TRAFFIC_MESSAGE_MAX_SIZE);
+        return FALSE;
+    }
+    config->min_size = (gsize) min_size;
+    config->max_size = (gsize) MAX (min_size, max_size);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+report_client (Context  *ctx,
+               gboolean  summary)
+{
+    QrtrTrafficStats  empty;
+    QrtrTrafficStats *from;
+    gdouble           elapsed;
+    gint64            now;
+    guint64           n_messages;
+    guint64           n_bytes;
+
+    now = g_get_monotonic_time ();
+    if (summary) {
+        /* from the first message received to the last one */
+        memset (&empty, 0, sizeof (empty));
+        from = &empty;
+        elapsed = (gdouble) (ctx->stats.last_time - ctx->stats.first_time) / G_USEC_PER_SEC;
+    } else {
+        from = &ctx->last_stats;
+        elapsed = (gdouble) (now - ctx->last_report_time) / G_USEC_PER_SEC;
+    }
+
+    n_messages = ctx->stats.n_messages - from->n_messages;
+    n_bytes = ctx->stats.n_bytes - from->n_bytes;
+
+    g_print ("%s%" G_GUINT64_FORMAT " messages, %.1f msg/s, %.3f MiB/s, "
+             "%" G_GUINT64_FORMAT " lost, %" G_GUINT64_FORMAT " late, "
+             "mean latency %.1f us, max latency %" G_GINT64_FORMAT " us",
+             summary ? "total: " : "",
+             n_messages,
+             elapsed > 0.0 ? n_messages / elapsed : 0.0,
+             elapsed > 0.0 ? n_bytes / elapsed / (1024.0 * 1024.0) : 0.0,
+             ctx->stats.n_lost - from->n_lost,
+             ctx->stats.n_late - from->n_late,
+             n_messages ? (gdouble) (ctx->stats.total_latency - from->total_latency) / n_messages : 0.0,
+             ctx->stats.max_latency);
+    if (ctx->config.mode == QRTR_TRAFFIC_MODE_ECHO)
+        g_print (", %" G_GUINT64_FORMAT " requests sent, %" G_GUINT64_FORMAT " failed",
+                 ctx->n_requests, ctx->n_requests_failed);
+    g_print ("\n");
+
+    ctx->last_stats = ctx->stats;
+    ctx->last_report_time = now;
+}
+
+static void
+report_generator (Context  *ctx,
+                  gboolean  summary)
+{
+    guint64 n_sent;
+    guint64 n_failed;
+    gdouble elapsed;
+
+    n_sent = qrtr_traffic_generator_get_n_sent (ctx->generator);
+    n_failed = qrtr_traffic_generator_get_n_failed (ctx->generator);
+
+    if (summary) {
+        elapsed = (gdouble) (g_get_monotonic_time () - ctx->start_time) / G_USEC_PER_SEC;
+        g_print ("total: %" G_GUINT64_FORMAT " messages sent, %.1f msg/s, %" G_GUINT64_FORMAT " failed\n",
+                 n_sent, elapsed > 0.0 ? n_sent / elapsed : 0.0, n_failed);
+        return;
+    }
+
+    g_print ("%" G_GUINT64_FORMAT " msg/s sent, %" G_GUINT64_FORMAT " failed, %u peers\n",
+             n_sent - ctx->last_sent, n_failed - ctx->last_failed,
+             qrtr_server_get_n_peers (ctx->server));
+    ctx->last_sent = n_sent;
+    ctx->last_failed = n_failed;
+}
+
+static gboolean
+report_cb (Context *ctx)
+{
+    if (ctx->generator)
+        report_generator (ctx, FALSE);
+    else if (ctx->client)
+        report_client (ctx, FALSE);
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+quit_cb (Context *ctx)
+{
+    g_main_loop_quit (ctx->loop);
+    return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+send_request (Context *ctx,
+              guint32  sequence,
+              gsize    size)
+{
+    g_autoptr(GByteArray) request = NULL;
+    g_autoptr(GError)     error = NULL;
+
+    request = g_bytes_unref_to_array (qrtr_traffic_message_new (sequence, size));
+    if (!qrtr_client_send (ctx->client, request, NULL, &error)) {
+        g_debug ("couldn't send request: %s", error->message);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+request_tick_cb (Context *ctx)
+{
+    gint64 now;
+    guint  n = 0;
+
+    now = g_get_monotonic_time ();
+    while (ctx->next_time <= now && n++ < REQUEST_TICK_MAX) {
+        /* requests not sent don't take a sequence number */
+        if (send_request (ctx, ctx->sequence, qrtr_traffic_config_next_size (&ctx->config, ctx->rand))) {
+            ctx->sequence++;
+            ctx->n_requests++;
+        } else
+            ctx->n_requests_failed++;
+        ctx->next_time += qrtr_traffic_config_next_interval (&ctx->config, ctx->rand);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+client_message_cb (QrtrClient *client,
+                   GBytes     *message,
+                   Context    *ctx)
+{
+    qrtr_traffic_stats_add_message (&ctx->stats, message);
+}
+
+static void
+resolve_service_ready (QrtrBus      *bus,
+                       GAsyncResult *res,
+                       Context      *ctx)
+{
+    g_autoptr(GError) error = NULL;
+    guint32           node_id;
+    guint32           port;
+
+    if (!qrtr_bus_resolve_service_finish (bus, res, &node_id, &port, &ctx->client, &error)) {
+        g_printerr ("error: couldn't find service %d: %s\n", service, error->message);
+        ctx->exit_status = EXIT_FAILURE;
+        g_main_loop_quit (ctx->loop);
+        return;
+    }
+
+    g_print ("connected to service %d at %u:%u\n", service, node_id, port);
+    g_signal_connect (ctx->client,
+                      QRTR_CLIENT_SIGNAL_MESSAGE_BYTES,
+                      G_CALLBACK (client_message_cb),
+                      ctx);
+
+    if (ctx->config.mode == QRTR_TRAFFIC_MODE_ECHO) {
+        ctx->rand = g_rand_new ();
+        ctx->next_time = (gdouble) g_get_monotonic_time ();
+        g_timeout_add (REQUEST_TICK_MS, (GSourceFunc) request_tick_cb, ctx);
+    } else if (!send_request (ctx, 0, QRTR_TRAFFIC_MESSAGE_MIN_SIZE)) {
+        /* any request subscribes to the indications */
+        g_printerr ("error: couldn't subscribe to indications\n");
+        ctx->exit_status = EXIT_FAILURE;
+        g_main_loop_quit (ctx->loop);
+        return;
+    }
+
+    ctx->start_time = ctx->last_report_time = g_get_monotonic_time ();
+    g_timeout_add_seconds (1, (GSourceFunc) report_cb, ctx);
+    if (duration > 0)
+        g_timeout_add_seconds ((guint) duration, (GSourceFunc) quit_cb, ctx);
+}
+
+static void
+bus_new_ready (GObject      *source,
+               GAsyncResult *res,
+               Context      *ctx)
+{
+    g_autoptr(GError) error = NULL;
+
+    ctx->bus = qrtr_bus_new_finish (res, &error);
+    if (!ctx->bus) {
+        g_printerr ("error: couldn't access the QRTR bus: %s\n", error->message);
+        ctx->exit_status = EXIT_FAILURE;
+        g_main_loop_quit (ctx->loop);
+        return;
+    }
+
+    qrtr_bus_resolve_service (ctx->bus,
+                              QRTR_BUS_NODE_ID_ANY,
+                              (guint32) service,
+                              version < 0 ? 0 : (guint32) version,
+                              version < 0 ? G_MAXUINT8 : (guint32) version,
+                              instance < 0 ? QRTR_NODE_INSTANCE_ANY : (guint32) instance,
+                              RESOLVE_TIMEOUT_MS,
+                              NULL,
+                              (GAsyncReadyCallback) resolve_service_ready,
+                              ctx);
+}
+
+static gboolean
+start_generator (Context *ctx)
+{
+    g_autoptr(GError) error = NULL;
+
+    ctx->server = qrtr_server_new ((guint32) service,
+                                   version < 0 ? 0 : (guint32) version,
+                                   instance < 0 ? 0 : (guint32) instance,
+                                   NULL,
+                                   &error);
+    if (!ctx->server) {
+        g_printerr ("error: couldn't publish service %d: %s\n", service, error->message);
+        return FALSE;
+    }
+
+    ctx->generator = qrtr_traffic_generator_new (ctx->server, &ctx->config);
+    g_print ("service %d published at %u:%u\n", service,
+             qrtr_server_get_node_id (ctx->server), qrtr_server_get_port (ctx->server));
+
+    ctx->start_time = g_get_monotonic_time ();
+    g_timeout_add_seconds (1, (GSourceFunc) report_cb, ctx);
+    if (duration > 0)
+        g_timeout_add_seconds ((guint) duration, (GSourceFunc) quit_cb, ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char **argv)
+{
+    g_autoptr(GOptionContext) option_context = NULL;
+    g_autoptr(GError)         error = NULL;
+    Context                   ctx;
+
+    option_context = g_option_context_new ("- Synthetic QRTR traffic for datapath load tests");
+    g_option_context_add_main_entries (option_context, main_entries, NULL);
+    if (!g_option_context_parse (option_context, &argc, &argv, &error)) {
+        g_printerr ("error: couldn't parse option context: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    if (service < 0) {
+        g_printerr ("error: a service must be given with --service\n");
+        return EXIT_FAILURE;
+    }
+
+    memset (&ctx, 0, sizeof (ctx));
+    if (!parse_config (&ctx.config))
+        return EXIT_FAILURE;
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.exit_status = EXIT_SUCCESS;
+    g_unix_signal_add (SIGINT, (GSourceFunc) quit_cb, &ctx);
+    g_unix_signal_add (SIGTERM, (GSourceFunc) quit_cb, &ctx);
+
+    if (client_flag)
+        qrtr_bus_new (1000, NULL, (GAsyncReadyCallback) bus_new_ready, &ctx);
+    else if (!start_generator (&ctx))
+        ctx.exit_status = EXIT_FAILURE;
+
+    if (ctx.exit_status == EXIT_SUCCESS)
+        g_main_loop_run (ctx.loop);
+
+    if (ctx.generator)
+        report_generator (&ctx, TRUE);
+    else if (ctx.client)
+        report_client (&ctx, TRUE);
+
+    g_clear_object (&ctx.generator);
+    g_clear_object (&ctx.server);
+    g_clear_object (&ctx.client);
+    g_clear_object (&ctx.bus);
+    g_clear_pointer (&ctx.rand, g_rand_free);
+    g_main_loop_unref (ctx.loop);
+
+    return ctx.exit_status;
+}